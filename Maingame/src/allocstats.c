@@ -0,0 +1,72 @@
+#include "allocstats.h"
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+
+static SDL_malloc_func realMalloc;
+static SDL_calloc_func realCalloc;
+static SDL_realloc_func realRealloc;
+static SDL_free_func realFree;
+static atomic_ulong allocCount;
+static atomic_ullong allocBytes;
+static _Thread_local AllocSnapshot threadStats;
+
+static void countAlloc(size_t bytes) {
+    atomic_fetch_add_explicit(&allocCount, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&allocBytes, bytes, memory_order_relaxed);
+    threadStats.count++;
+    threadStats.bytes += bytes;
+}
+
+static void* SDLCALL countingMalloc(size_t size) {
+    countAlloc(size);
+    return realMalloc(size);
+}
+
+static void* SDLCALL countingCalloc(size_t nmemb, size_t size) {
+    countAlloc(nmemb * size);
+    return realCalloc(nmemb, size);
+}
+
+static void* SDLCALL countingRealloc(void* mem, size_t size) {
+    countAlloc(size);
+    return realRealloc(mem, size);
+}
+
+#ifdef ALLOCSTATS_WRAP
+// The linker routes our objects' malloc calls here and the originals to __real_*
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* mem, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    countAlloc(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+    countAlloc(nmemb * size);
+    return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* mem, size_t size) {
+    countAlloc(size);
+    return __real_realloc(mem, size);
+}
+#endif
+
+int allocStatsInstall(void) {
+    SDL_GetMemoryFunctions(&realMalloc, &realCalloc, &realRealloc, &realFree);
+    return SDL_SetMemoryFunctions(countingMalloc, countingCalloc, countingRealloc, realFree);
+}
+
+unsigned long allocStatsCount(void) {
+    return atomic_load_explicit(&allocCount, memory_order_relaxed);
+}
+
+unsigned long long allocStatsBytes(void) {
+    return atomic_load_explicit(&allocBytes, memory_order_relaxed);
+}
+
+AllocSnapshot allocStatsThread(void) {
+    return threadStats;
+}
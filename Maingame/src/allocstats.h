@@ -0,0 +1,28 @@
+#ifndef ALLOCSTATS_H
+#define ALLOCSTATS_H
+
+/*
+   Counts heap allocations made through SDL_malloc and friends, which is
+   what SDL, SDL_image, SDL_mixer and SDL_ttf allocate with. Built with
+   -DALLOCSTATS_WRAP and linked with
+   -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+   our own malloc/calloc/realloc calls are counted too. Totals are atomic
+   since the audio thread allocates; each thread also keeps its own, so the
+   main loop can check its frames in isolation.
+*/
+
+typedef struct {
+    unsigned long count;
+    unsigned long long bytes;
+} AllocSnapshot;
+
+/* Wraps SDL's allocator; call before SDL_Init. Returns 0 on success. */
+int allocStatsInstall(void);
+/* malloc/calloc/realloc calls seen so far, all threads. */
+unsigned long allocStatsCount(void);
+/* Bytes requested by those calls. */
+unsigned long long allocStatsBytes(void);
+/* Calls and bytes so far on the calling thread; subtract two for a frame's worth. */
+AllocSnapshot allocStatsThread(void);
+
+#endif
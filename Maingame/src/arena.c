@@ -0,0 +1,30 @@
+#include "arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+int arenaInit(FrameArena* a, size_t size) {
+    memset(a, 0, sizeof(*a));
+    // Over-allocate so base can be aligned without aligned_alloc (missing on MinGW)
+    a->base = malloc(size + ARENA_ALIGN);
+    if (!a->base) return -1;
+    a->size = size;
+    return 0;
+}
+
+void arenaFree(FrameArena* a) {
+    free(a->base);
+    memset(a, 0, sizeof(*a));
+}
+
+void arenaReset(FrameArena* a) {
+    if (a->used > a->peak) a->peak = a->used;
+    a->used = 0;
+}
+
+void* arenaAlloc(FrameArena* a, size_t bytes) {
+    unsigned char* start = (unsigned char*)(((size_t)a->base + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1));
+    size_t offset = (a->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (!a->base || offset + bytes > a->size) { a->failures++; return NULL; }
+    a->used = offset + bytes;
+    return start + offset;
+}
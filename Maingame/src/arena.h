@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+   Bump allocator for data that lives for one frame: render quads and the
+   like. One block is allocated up front; arenaReset at the top of every
+   loop iteration frees everything at once, so steady-state frames never
+   touch the heap.
+*/
+
+#define FRAME_ARENA_SIZE (256 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct {
+    unsigned char* base;
+    size_t size, used;
+    size_t peak; // most ever used in one frame
+    unsigned long failures; // allocations that didn't fit
+} FrameArena;
+
+int arenaInit(FrameArena* a, size_t size);
+void arenaFree(FrameArena* a);
+void arenaReset(FrameArena* a);
+/* Returns ARENA_ALIGN-aligned memory valid until the next reset, or NULL when full. */
+void* arenaAlloc(FrameArena* a, size_t bytes);
+
+#endif
@@ -0,0 +1,236 @@
+#include "atlas.h"
+#include "log.h"
+#include "game.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    const char* path;
+    int w, h; // size the sprite is drawn at
+} SpriteDef;
+
+// Pipes are stretched vertically when drawn, so they are packed at the tallest size used
+static const SpriteDef spriteDefs[SPRITE_COUNT] = {
+    [SPRITE_BG]          = {"assets/sprites/bg.png", WINDOW_WIDTH, WINDOW_HEIGHT},
+    [SPRITE_BIRD]        = {"assets/sprites/Bird.png", BIRD_W, BIRD_H},
+    [SPRITE_BIRD_DASH]   = {"assets/sprites/Bird_dash.png", BIRD_W, BIRD_H},
+    [SPRITE_PIPE_TOP]    = {"assets/sprites/pipe_top.png", PIPE_WIDTH, PIPE_MAX_HEIGHT},
+    [SPRITE_PIPE_BOTTOM] = {"assets/sprites/pipe_bottom.png", PIPE_WIDTH, PIPE_MAX_HEIGHT},
+    [SPRITE_RESTART]     = {"assets/sprites/restart.png", 300, 100},
+    [SPRITE_START]       = {"assets/sprites/start.png", 800, 200},
+};
+
+/* Shelf packer: tallest sprites first, new row when the current one is full.
+   Returns the atlas height needed. */
+static int packRegions(SDL_Rect regions[SPRITE_COUNT]) {
+    int order[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; i++) order[i] = i;
+    for (int i = 1; i < SPRITE_COUNT; i++) {
+        int o = order[i], j = i;
+        while (j > 0 && spriteDefs[order[j - 1]].h < spriteDefs[o].h) { order[j] = order[j - 1]; j--; }
+        order[j] = o;
+    }
+
+    int x = 0, y = 0, rowHeight = 0;
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        const SpriteDef* d = &spriteDefs[order[i]];
+        if (x + d->w + ATLAS_PADDING > ATLAS_WIDTH) { x = 0; y += rowHeight; rowHeight = 0; }
+        regions[order[i]] = (SDL_Rect){x, y, d->w, d->h};
+        x += d->w + ATLAS_PADDING;
+        if (d->h + ATLAS_PADDING > rowHeight) rowHeight = d->h + ATLAS_PADDING;
+    }
+    return y + rowHeight;
+}
+
+/* Coverage weights of the source texels under each destination texel along one axis. */
+typedef struct {
+    int first, count;
+    float weights[64];
+} AreaSpan;
+
+static AreaSpan* buildSpans(int srcLen, int dstLen) {
+    AreaSpan* spans = malloc(sizeof(AreaSpan) * dstLen);
+    if (!spans) return NULL;
+    float scale = (float)srcLen / dstLen;
+    for (int d = 0; d < dstLen; d++) {
+        float x0 = d * scale, x1 = (d + 1) * scale;
+        AreaSpan* s = &spans[d];
+        s->first = (int)x0;
+        s->count = 0;
+        for (int i = s->first; i < x1 && i < srcLen && s->count < 64; i++) {
+            float w = SDL_min(x1, i + 1.0f) - SDL_max(x0, (float)i);
+            s->weights[s->count++] = w / scale;
+        }
+    }
+    return spans;
+}
+
+/* Downscales src into dstRect of dst (both RGBA32) with a box filter: every
+   destination texel is the area-weighted mean of the source texels it covers.
+   Colour is averaged premultiplied so transparent texels don't darken edges.
+   Done once at load time, so it favours quality over speed. */
+static int resampleArea(SDL_Surface* src, SDL_Surface* dst, const SDL_Rect* dstRect) {
+    int sw = src->w, sh = src->h, dw = dstRect->w, dh = dstRect->h;
+    if (dw > sw || dh > sh || sw / dw >= 64 || sh / dh >= 64)
+        return SDL_SoftStretchLinear(src, NULL, dst, (SDL_Rect*)dstRect);
+
+    AreaSpan* xs = buildSpans(sw, dw);
+    AreaSpan* ys = buildSpans(sh, dh);
+    float* rows = malloc(sizeof(float) * 4 * dw * sh); // horizontal pass, premultiplied
+    if (!xs || !ys || !rows) { free(xs); free(ys); free(rows); return SDL_OutOfMemory(); }
+
+    for (int y = 0; y < sh; y++) {
+        const Uint8* in = (const Uint8*)src->pixels + y * src->pitch;
+        float* out = rows + 4 * dw * y;
+        for (int x = 0; x < dw; x++) {
+            float r = 0, g = 0, b = 0, al = 0;
+            for (int k = 0; k < xs[x].count; k++) {
+                const Uint8* p = in + 4 * (xs[x].first + k);
+                float wa = xs[x].weights[k] * p[3];
+                r += p[0] * wa; g += p[1] * wa; b += p[2] * wa; al += wa;
+            }
+            out[4 * x] = r; out[4 * x + 1] = g; out[4 * x + 2] = b; out[4 * x + 3] = al;
+        }
+    }
+
+    for (int y = 0; y < dh; y++) {
+        Uint8* out = (Uint8*)dst->pixels + (dstRect->y + y) * dst->pitch + 4 * dstRect->x;
+        for (int x = 0; x < dw; x++) {
+            float r = 0, g = 0, b = 0, al = 0;
+            for (int k = 0; k < ys[y].count; k++) {
+                const float* p = rows + 4 * (dw * (ys[y].first + k) + x);
+                float w = ys[y].weights[k];
+                r += p[0] * w; g += p[1] * w; b += p[2] * w; al += p[3] * w;
+            }
+            if (al > 0) { r /= al; g /= al; b /= al; }
+            out[4 * x]     = (Uint8)SDL_min(r + 0.5f, 255.0f);
+            out[4 * x + 1] = (Uint8)SDL_min(g + 0.5f, 255.0f);
+            out[4 * x + 2] = (Uint8)SDL_min(b + 0.5f, 255.0f);
+            out[4 * x + 3] = (Uint8)SDL_min(al + 0.5f, 255.0f);
+        }
+    }
+
+    free(xs);
+    free(ys);
+    free(rows);
+    return 0;
+}
+
+int atlasLoad(Atlas* a, SDL_Renderer* renderer, StartupTimeline* timeline, int flags) {
+    memset(a, 0, sizeof(*a));
+
+    int height = packRegions(a->regions);
+    int h = 1;
+    while (h < height) h <<= 1;
+    a->w = ATLAS_WIDTH;
+    a->h = h;
+
+    SDL_Surface* atlasSurf = SDL_CreateRGBSurfaceWithFormat(0, a->w, a->h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (!atlasSurf) { logError("can't create atlas surface", logStr("error", SDL_GetError())); return -1; }
+    SDL_FillRect(atlasSurf, NULL, 0);
+
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        SDL_Surface* loaded = IMG_Load(spriteDefs[i].path);
+        if (!loaded) { logWarn("can't load sprite", logStr("path", spriteDefs[i].path), logStr("error", IMG_GetError())); continue; }
+        SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+        SDL_FreeSurface(loaded);
+        if (!rgba) continue;
+        a->sourceW[i] = rgba->w;
+        a->sourceH[i] = rgba->h;
+
+        if (resampleArea(rgba, atlasSurf, &a->regions[i]) == 0) a->loaded[i] = 1;
+        else logWarn("can't scale sprite", logStr("path", spriteDefs[i].path), logStr("error", SDL_GetError()));
+        SDL_FreeSurface(rgba);
+        const char* file = strrchr(spriteDefs[i].path, '/');
+        startupMark(timeline, file ? file + 1 : spriteDefs[i].path);
+    }
+
+    a->texture = SDL_CreateTextureFromSurface(renderer, atlasSurf);
+    if (flags & ATLAS_KEEP_PIXELS) a->pixels = atlasSurf;
+    else SDL_FreeSurface(atlasSurf);
+    startupMark(timeline, "atlas upload");
+    if (!a->texture) { logError("can't upload atlas", logStr("error", SDL_GetError())); return -1; }
+    SDL_SetTextureBlendMode(a->texture, SDL_BLENDMODE_BLEND);
+    return 0;
+}
+
+void atlasDestroy(Atlas* a) {
+    if (a->texture) SDL_DestroyTexture(a->texture);
+    a->texture = NULL;
+    atlasReleasePixels(a);
+}
+
+void atlasReleasePixels(Atlas* a) {
+    if (a->pixels) SDL_FreeSurface(a->pixels);
+    a->pixels = NULL;
+}
+
+void atlasPrintMemory(const Atlas* a, FILE* out) {
+    long before = 0, after = 0;
+    fprintf(out, "%-30s %11s %9s %11s %9s\n", "sprite", "source", "KB", "packed", "KB");
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        if (!a->loaded[i]) continue;
+        long src = (long)a->sourceW[i] * a->sourceH[i] * 4;
+        long dst = (long)a->regions[i].w * a->regions[i].h * 4;
+        fprintf(out, "%-30s %5dx%-5d %9ld %5dx%-5d %9ld\n", spriteDefs[i].path,
+            a->sourceW[i], a->sourceH[i], src / 1024, a->regions[i].w, a->regions[i].h, dst / 1024);
+        before += src;
+        after += dst;
+    }
+    fprintf(out, "sprites: %ld KB at source size, %ld KB packed, atlas texture %dx%d = %ld KB\n",
+        before / 1024, after / 1024, a->w, a->h, (long)a->w * a->h * 4 / 1024);
+}
+
+void batchBegin(SpriteBatch* b, FrameArena* arena, int maxQuads) {
+    b->vertices = arenaAlloc(arena, sizeof(SDL_Vertex) * 4 * maxQuads);
+    b->indices = arenaAlloc(arena, sizeof(int) * 6 * maxQuads);
+    b->capacity = b->vertices && b->indices ? maxQuads : 0;
+    b->quadCount = 0;
+}
+
+void batchSprite(SpriteBatch* b, const Atlas* a, int sprite, const SDL_Rect* dst, float angle) {
+    if (!a->loaded[sprite] || b->quadCount >= b->capacity) return;
+
+    const SDL_Rect* r = &a->regions[sprite];
+    float u0 = (float)r->x / a->w, v0 = (float)r->y / a->h;
+    float u1 = (float)(r->x + r->w) / a->w, v1 = (float)(r->y + r->h) / a->h;
+
+    // Corners relative to the centre: TL, TR, BR, BL
+    float hw = dst->w * 0.5f, hh = dst->h * 0.5f;
+    float cx = dst->x + hw, cy = dst->y + hh;
+    const float dx[4] = {-hw, hw, hw, -hw};
+    const float dy[4] = {-hh, -hh, hh, hh};
+    const float u[4] = {u0, u1, u1, u0};
+    const float v[4] = {v0, v0, v1, v1};
+    float c = 1.0f, s = 0.0f;
+    if (angle != 0.0f) {
+        float rad = angle * (float)M_PI / 180.0f;
+        c = SDL_cosf(rad);
+        s = SDL_sinf(rad);
+    }
+
+    SDL_Vertex* vert = &b->vertices[b->quadCount * 4];
+    for (int i = 0; i < 4; i++) {
+        vert[i].position.x = cx + dx[i] * c - dy[i] * s;
+        vert[i].position.y = cy + dx[i] * s + dy[i] * c;
+        vert[i].color = (SDL_Color){255, 255, 255, 255};
+        vert[i].tex_coord.x = u[i];
+        vert[i].tex_coord.y = v[i];
+    }
+
+    int base = b->quadCount * 4;
+    int* idx = &b->indices[b->quadCount * 6];
+    idx[0] = base; idx[1] = base + 1; idx[2] = base + 2;
+    idx[3] = base; idx[4] = base + 2; idx[5] = base + 3;
+    b->quadCount++;
+}
+
+int batchFlush(SpriteBatch* b, SDL_Renderer* renderer, const Atlas* a) {
+    int result = 0;
+    if (b->quadCount > 0 && a->texture)
+        result = SDL_RenderGeometry(renderer, a->texture, b->vertices, b->quadCount * 4, b->indices, b->quadCount * 6);
+    b->quadCount = 0;
+    return result;
+}
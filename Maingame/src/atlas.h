@@ -0,0 +1,64 @@
+#ifndef ATLAS_H
+#define ATLAS_H
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include "arena.h"
+#include "startup.h"
+
+/*
+   All game sprites packed into one texture at load time, plus a quad batch
+   that submits a whole frame's sprites with a single SDL_RenderGeometry call.
+*/
+
+enum {
+    SPRITE_BG,
+    SPRITE_BIRD,
+    SPRITE_BIRD_DASH,
+    SPRITE_PIPE_TOP,
+    SPRITE_PIPE_BOTTOM,
+    SPRITE_RESTART,
+    SPRITE_START,
+    SPRITE_COUNT
+};
+
+#define ATLAS_WIDTH 2048
+#define ATLAS_PADDING 2
+#define BATCH_MAX_QUADS 256 // per batchBegin; more than any real frame draws
+
+#define ATLAS_KEEP_PIXELS 0x1 // atlasLoad flag: keep a CPU-side copy in Atlas.pixels
+
+typedef struct {
+    SDL_Texture* texture;
+    int w, h;
+    SDL_Rect regions[SPRITE_COUNT];
+    int loaded[SPRITE_COUNT];
+    int sourceW[SPRITE_COUNT], sourceH[SPRITE_COUNT]; // size of the PNG before downscaling
+    SDL_Surface* pixels; // RGBA32, same layout as texture; NULL unless ATLAS_KEEP_PIXELS
+} Atlas;
+
+// Vertex and index storage comes from the frame arena
+typedef struct {
+    SDL_Vertex* vertices;
+    int* indices;
+    int quadCount, capacity;
+} SpriteBatch;
+
+/* Loads every sprite, scales it to its on-screen size and packs it.
+   Returns 0 on success; missing sprite files are skipped, not fatal. Each
+   decode and the upload are marked on timeline, which may be NULL. */
+int atlasLoad(Atlas* a, SDL_Renderer* renderer, StartupTimeline* timeline, int flags);
+void atlasDestroy(Atlas* a);
+/* Frees the CPU-side copy once nothing needs it. */
+void atlasReleasePixels(Atlas* a);
+/* Prints RGBA bytes per sprite at source resolution vs. as packed. */
+void atlasPrintMemory(const Atlas* a, FILE* out);
+
+/* Takes room for maxQuads from the arena; quads past what fitted are dropped. */
+void batchBegin(SpriteBatch* b, FrameArena* arena, int maxQuads);
+/* Queues sprite into dst, rotated clockwise by angle degrees around its centre. */
+void batchSprite(SpriteBatch* b, const Atlas* a, int sprite, const SDL_Rect* dst, float angle);
+/* Draws everything queued since batchBegin; returns the SDL_RenderGeometry result. */
+int batchFlush(SpriteBatch* b, SDL_Renderer* renderer, const Atlas* a);
+
+#endif
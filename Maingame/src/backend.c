@@ -0,0 +1,246 @@
+#include "backend.h"
+#include "game.h"
+#include "log.h"
+#include <string.h>
+
+static const SDL_Color white = {255, 255, 255, 255};
+
+/* Pre-rotated frame for the sprite, centred on where dst would be; -1 when
+   the cache doesn't have it. */
+static int rotatedCell(RenderBackend* b, int sprite, const SDL_Rect* dst, float angle, SDL_Rect* cell, SDL_Rect* out) {
+    if (!b->rotations || rotCacheGet(b->rotations, sprite, angle, cell) != 0) return -1;
+    *out = (SDL_Rect){dst->x + (dst->w - cell->w) / 2, dst->y + (dst->h - cell->h) / 2, cell->w, cell->h};
+    return 0;
+}
+
+/* --- SDL --- */
+
+static void sdlBegin(RenderBackend* b) {
+    SDL_RenderClear(b->renderer);
+    batchBegin(&b->batch, b->arena, BATCH_MAX_QUADS);
+}
+
+static void sdlSprite(RenderBackend* b, int sprite, const SDL_Rect* dst, float angle) {
+    SDL_Rect cell, out;
+    if (rotatedCell(b, sprite, dst, angle, &cell, &out) != 0) {
+        batchSprite(&b->batch, b->atlas, sprite, dst, angle);
+        return;
+    }
+    // A plain copy of the pre-rotated frame; what's queued goes first so it stays on top
+    batchFlush(&b->batch, b->renderer, b->atlas);
+    SDL_RenderCopy(b->renderer, b->rotations->texture, &cell, &out);
+}
+
+static void sdlText(RenderBackend* b, const char* label, int number, int x, int y) {
+    int w, h;
+    batchFlush(&b->batch, b->renderer, b->atlas);
+    SDL_Texture* tex = textCacheGet(b->textCache, b->font, label, white, &w, &h);
+    if (!tex) return;
+    SDL_Rect dst = {x, y, w, h};
+    SDL_RenderCopy(b->renderer, tex, NULL, &dst);
+    if (number >= 0) digitStripDraw(b->digits, b->renderer, number, x + w, y);
+}
+
+static void sdlTextSize(RenderBackend* b, const char* label, int number, int* w, int* h) {
+    *w = *h = 0;
+    if (!textCacheGet(b->textCache, b->font, label, white, w, h)) return;
+    if (number >= 0) *w += digitStripWidth(b->digits, number);
+}
+
+static void sdlFlush(RenderBackend* b) {
+    batchFlush(&b->batch, b->renderer, b->atlas);
+}
+
+static void sdlPresent(RenderBackend* b) {
+    SDL_RenderPresent(b->renderer);
+}
+
+void backendInitSdl(RenderBackend* b, SDL_Renderer* renderer, const Atlas* atlas, RotCache* rotations,
+    FrameArena* arena, TextCache* text, const DigitStrip* digits, TTF_Font* font) {
+    memset(b, 0, sizeof(*b));
+    b->kind = BACKEND_SDL;
+    b->begin = sdlBegin;
+    b->sprite = sdlSprite;
+    b->text = sdlText;
+    b->textSize = sdlTextSize;
+    b->flush = sdlFlush;
+    b->present = sdlPresent;
+    b->renderer = renderer;
+    b->atlas = atlas;
+    b->rotations = rotations;
+    b->arena = arena;
+    b->textCache = text;
+    b->digits = digits;
+    b->font = font;
+}
+
+/* --- CPU --- */
+
+static void cpuBackendBegin(RenderBackend* b) {
+    cpuBegin(b->cpu);
+}
+
+static void cpuBackendSprite(RenderBackend* b, int sprite, const SDL_Rect* dst, float angle) {
+    SDL_Rect cell, out;
+    if (rotatedCell(b, sprite, dst, angle, &cell, &out) == 0)
+        cpuImage(b->cpu, b->rotations->pixels, b->rotations->columns * b->rotations->cellW, &cell, &out);
+    else
+        cpuSprite(b->cpu, sprite, dst); // no rotation without the cache
+}
+
+static void cpuBackendText(RenderBackend* b, const char* label, int number, int x, int y) {
+    const CpuText* t = cpuText(b->cpu, b->font, label);
+    if (!t) return;
+    cpuDrawText(b->cpu, t, x, y, white);
+    if (number >= 0) cpuNumber(b->cpu, number, x + t->w, y, white);
+}
+
+static void cpuBackendTextSize(RenderBackend* b, const char* label, int number, int* w, int* h) {
+    const CpuText* t = cpuText(b->cpu, b->font, label);
+    *w = t ? t->w : 0;
+    *h = t ? t->h : 0;
+    if (t && number >= 0) *w += cpuNumberWidth(b->cpu, number);
+}
+
+static void cpuBackendFlush(RenderBackend* b) {
+    cpuFlush(b->cpu); // composite, then upload and copy when there is a renderer
+}
+
+static void cpuBackendPresent(RenderBackend* b) {
+    if (b->renderer) SDL_RenderPresent(b->renderer);
+}
+
+void backendInitCpu(RenderBackend* b, CpuRenderer* cpu, const Atlas* atlas, RotCache* rotations, TTF_Font* font) {
+    memset(b, 0, sizeof(*b));
+    b->kind = BACKEND_CPU;
+    b->begin = cpuBackendBegin;
+    b->sprite = cpuBackendSprite;
+    b->text = cpuBackendText;
+    b->textSize = cpuBackendTextSize;
+    b->flush = cpuBackendFlush;
+    b->present = cpuBackendPresent;
+    b->renderer = cpu->renderer;
+    b->atlas = atlas;
+    b->rotations = rotations;
+    b->font = font;
+    b->cpu = cpu;
+}
+
+/* --- Null --- */
+
+static void nullNothing(RenderBackend* b) {
+    (void)b;
+}
+
+static void nullSprite(RenderBackend* b, int sprite, const SDL_Rect* dst, float angle) {
+    (void)sprite; (void)dst; (void)angle;
+    b->sprites++;
+}
+
+static void nullText(RenderBackend* b, const char* label, int number, int x, int y) {
+    (void)label; (void)number; (void)x; (void)y;
+    b->texts++;
+}
+
+static void nullTextSize(RenderBackend* b, const char* label, int number, int* w, int* h) {
+    (void)b; (void)label; (void)number;
+    *w = *h = 0;
+}
+
+static void nullPresent(RenderBackend* b) {
+    b->frames++;
+}
+
+void backendInitNull(RenderBackend* b) {
+    memset(b, 0, sizeof(*b));
+    b->kind = BACKEND_NULL;
+    b->begin = nullNothing;
+    b->sprite = nullSprite;
+    b->text = nullText;
+    b->textSize = nullTextSize;
+    b->flush = nullNothing;
+    b->present = nullPresent;
+}
+
+static const char* const backendNames[] = {"sdl", "cpu", "null"};
+
+const char* backendName(int kind) {
+    return kind >= 0 && kind <= BACKEND_NULL ? backendNames[kind] : "?";
+}
+
+int backendByName(const char* name) {
+    for (int i = 0; i <= BACKEND_NULL; i++)
+        if (strcmp(name, backendNames[i]) == 0) return i;
+    return -1;
+}
+
+/* --- Driver selection --- */
+
+/* The background stretched over the window, a dozen blended pipe-sized
+   quads and one rotated bird, from a single texture. */
+static void drawProbeFrame(SDL_Renderer* renderer, SDL_Texture* texture, int frame) {
+    SDL_Rect screen = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, NULL, &screen);
+    for (int i = 0; i < 12; i++) {
+        SDL_Rect pipe = {(i / 2) * 230 - frame % 230, i % 2 ? 420 : 0, PIPE_WIDTH, 300};
+        SDL_RenderCopy(renderer, texture, NULL, &pipe);
+    }
+    SDL_Rect bird = {BIRD_X, WINDOW_HEIGHT / 2, BIRD_W, BIRD_H};
+    SDL_RenderCopyEx(renderer, texture, NULL, &bird, (double)(frame % 90 - 45), NULL, SDL_FLIP_NONE);
+    SDL_RenderPresent(renderer);
+}
+
+/* Frames per second on one driver, or 0 if it can't be used. */
+static double probeDriver(SDL_Window* window, int index, int ms, SDL_RendererInfo* info) {
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, index, 0); // no vsync: it would cap every driver alike
+    if (!renderer) return 0;
+    double fps = 0;
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormat(0, 256, 256, 32, SDL_PIXELFORMAT_RGBA32);
+    SDL_Texture* texture = NULL;
+    if (surface && SDL_GetRendererInfo(renderer, info) == 0) {
+        for (int y = 0; y < 256; y++)
+            for (int x = 0; x < 256; x++)
+                ((Uint32*)surface->pixels)[y * 256 + x] = SDL_MapRGBA(surface->format, (Uint8)x, (Uint8)y, 128, (Uint8)(x ^ y));
+        texture = SDL_CreateTextureFromSurface(renderer, surface);
+    }
+    if (texture) {
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        drawProbeFrame(renderer, texture, 0); // first use uploads and compiles; not timed
+        Uint64 freq = SDL_GetPerformanceFrequency(), start = SDL_GetPerformanceCounter();
+        Uint64 end = start + freq * ms / 1000, now = start;
+        int frames = 0;
+        while (now < end) {
+            drawProbeFrame(renderer, texture, ++frames);
+            now = SDL_GetPerformanceCounter();
+        }
+        // Reading a pixel back waits for frames the driver has only queued
+        Uint32 pixel;
+        SDL_Rect one = {0, 0, 1, 1};
+        SDL_RenderReadPixels(renderer, &one, SDL_PIXELFORMAT_ARGB8888, &pixel, sizeof(pixel));
+        now = SDL_GetPerformanceCounter();
+        fps = frames * (double)freq / (double)(now - start);
+        SDL_DestroyTexture(texture);
+    }
+    if (surface) SDL_FreeSurface(surface);
+    SDL_DestroyRenderer(renderer);
+    return fps;
+}
+
+int backendPickDriver(SDL_Window* window, int budgetMs) {
+    int count = SDL_GetNumRenderDrivers();
+    if (count <= 0) return -1;
+    int ms = SDL_max(budgetMs / count, 1), best = -1;
+    double bestFps = 0;
+    for (int i = 0; i < count; i++) {
+        SDL_RendererInfo info;
+        double fps = probeDriver(window, i, ms, &info);
+        if (fps <= 0) {
+            logDebug("render driver unavailable", logInt("index", i), logStr("error", SDL_GetError()));
+            continue;
+        }
+        logInfo("render driver", logStr("name", info.name), logNum("fps", fps));
+        if (fps > bestFps) { bestFps = fps; best = i; }
+    }
+    return best;
+}
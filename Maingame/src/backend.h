@@ -0,0 +1,74 @@
+#ifndef BACKEND_H
+#define BACKEND_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "atlas.h"
+#include "arena.h"
+#include "rotcache.h"
+#include "cpurender.h"
+#include "textcache.h"
+
+/*
+   What the scene draws with. A frame is begin, sprites and text, flush and
+   present; whether that becomes SDL render calls, a framebuffer composited
+   on the CPU or nothing at all is up to the backend:
+
+   - SDL: sprites are queued in one SpriteBatch, text comes from the text
+     cache and the digit strip.
+   - CPU: everything is recorded into a CpuRenderer and composited on flush.
+   - Null: counts what it is asked to draw and renders nothing, for timing
+     the game without a GPU in the way.
+*/
+
+enum {
+    BACKEND_SDL,
+    BACKEND_CPU,
+    BACKEND_NULL
+};
+
+#define BACKEND_AUTO_MS 200 // --renderer auto: time spent trying the SDL render drivers
+
+typedef struct RenderBackend RenderBackend;
+
+struct RenderBackend {
+    int kind;
+    void (*begin)(RenderBackend* b);
+    /* angle in degrees, clockwise about the centre of dst. Birds come from
+       the rotation cache when there is one. */
+    void (*sprite)(RenderBackend* b, int sprite, const SDL_Rect* dst, float angle);
+    /* White text: label, then number from pre-rendered digits unless it is
+       negative. Drawn over every sprite so far. */
+    void (*text)(RenderBackend* b, const char* label, int number, int x, int y);
+    void (*textSize)(RenderBackend* b, const char* label, int number, int* w, int* h);
+    /* Puts everything drawn so far on the renderer's target; anything drawn
+       with SDL directly goes after this. */
+    void (*flush)(RenderBackend* b);
+    void (*present)(RenderBackend* b);
+
+    SDL_Renderer* renderer; // NULL for the null backend, or a CPU one that only composites
+    const Atlas* atlas;
+    RotCache* rotations; // NULL: the SDL backend rotates quads, the CPU one doesn't rotate
+    FrameArena* arena;
+    SpriteBatch batch;
+    TextCache* textCache;
+    const DigitStrip* digits;
+    TTF_Font* font;
+    CpuRenderer* cpu;
+    unsigned long frames, sprites, texts; // counted by the null backend
+};
+
+void backendInitSdl(RenderBackend* b, SDL_Renderer* renderer, const Atlas* atlas, RotCache* rotations,
+    FrameArena* arena, TextCache* text, const DigitStrip* digits, TTF_Font* font);
+void backendInitCpu(RenderBackend* b, CpuRenderer* cpu, const Atlas* atlas, RotCache* rotations, TTF_Font* font);
+void backendInitNull(RenderBackend* b);
+const char* backendName(int kind);
+/* "sdl", "cpu", "null"; -1 when unknown. */
+int backendByName(const char* name);
+
+/* Draws a frame much like the game's on each SDL render driver in turn for
+   budgetMs in all and returns the index of the fastest, or -1 if none
+   could be created. */
+int backendPickDriver(SDL_Window* window, int budgetMs);
+
+#endif
@@ -0,0 +1,191 @@
+#include "batch.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#define BATCH_CHUNK 32 // games a worker pops from its own deque at a time
+
+// One per worker, padded so neighbouring owners don't false-share
+typedef struct {
+    atomic_flag lock;
+    unsigned long begin, end;
+    char pad[64];
+} WorkDeque;
+
+typedef struct {
+    const BatchOptions* opts;
+    WorkDeque* deques;
+    int index, count;
+    BatchResult result;
+    pthread_t thread;
+} Worker;
+
+int batchCpuCount(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static double wallSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void lockDeque(WorkDeque* d) {
+    while (atomic_flag_test_and_set_explicit(&d->lock, memory_order_acquire)) {}
+}
+
+static void unlockDeque(WorkDeque* d) {
+    atomic_flag_clear_explicit(&d->lock, memory_order_release);
+}
+
+/* Pops up to BATCH_CHUNK games from the front of the worker's own deque. */
+static int popOwn(WorkDeque* d, unsigned long* begin, unsigned long* end) {
+    lockDeque(d);
+    unsigned long n = d->end - d->begin;
+    if (n > BATCH_CHUNK) n = BATCH_CHUNK;
+    *begin = d->begin;
+    *end = d->begin + n;
+    d->begin += n;
+    unlockDeque(d);
+    return n > 0;
+}
+
+static unsigned long dequeSize(WorkDeque* d) {
+    lockDeque(d);
+    unsigned long n = d->end - d->begin;
+    unlockDeque(d);
+    return n;
+}
+
+/* Takes the back half of the range of whichever other worker has the most
+   left. The victim may have moved on by the time it is locked; then look again. */
+static int steal(Worker* w) {
+    for (;;) {
+        WorkDeque* victim = NULL;
+        unsigned long most = 0;
+        for (int k = 1; k < w->count; k++) {
+            WorkDeque* d = &w->deques[(w->index + k) % w->count];
+            unsigned long n = dequeSize(d);
+            if (n > most) { most = n; victim = d; }
+        }
+        if (!victim) return 0;
+
+        lockDeque(victim);
+        unsigned long remaining = victim->end - victim->begin;
+        unsigned long take = remaining > 1 ? remaining / 2 : remaining;
+        victim->end -= take;
+        unsigned long begin = victim->end;
+        unlockDeque(victim);
+        if (take == 0) continue;
+
+        WorkDeque* own = &w->deques[w->index];
+        lockDeque(own);
+        own->begin = begin;
+        own->end = begin + take;
+        unlockDeque(own);
+        w->result.steals++;
+        return 1;
+    }
+}
+
+static void playGame(const BatchOptions* o, unsigned long i, BatchResult* r) {
+    GameState g;
+    gameReset(&g, o->seed + i);
+    while (!g.gameOver && g.frame < o->maxTicks) gameStep(&g, o->controller(&g));
+
+    r->steps += g.frame;
+    if (!g.gameOver) { r->abandoned++; return; }
+    r->games++;
+    r->totalScore += g.score;
+    if (g.score > r->bestScore) r->bestScore = g.score;
+    r->scoreHistogram[g.score < BATCH_SCORE_BUCKETS ? g.score : BATCH_SCORE_BUCKETS - 1]++;
+}
+
+static void* workerMain(void* arg) {
+    Worker* w = arg;
+    unsigned long begin, end;
+    for (;;) {
+        while (popOwn(&w->deques[w->index], &begin, &end))
+            for (unsigned long i = begin; i < end; i++) playGame(w->opts, i, &w->result);
+        if (!steal(w)) break; // every deque was empty: work is never created, only moved, so we're done
+    }
+    return NULL;
+}
+
+int batchRun(const BatchOptions* opts, BatchResult* result) {
+    int count = opts->threads > 0 ? opts->threads : batchCpuCount();
+    if (count > BATCH_MAX_THREADS) count = BATCH_MAX_THREADS;
+
+    Worker* workers = calloc(count, sizeof(Worker));
+    WorkDeque* deques = calloc(count, sizeof(WorkDeque));
+    if (!workers || !deques) { free(workers); free(deques); return -1; }
+
+    // Deal the games out evenly; stealing evens out the uneven game lengths
+    for (int i = 0; i < count; i++) {
+        atomic_flag_clear(&deques[i].lock);
+        deques[i].begin = opts->games * i / count;
+        deques[i].end = opts->games * (i + 1) / count;
+        workers[i].opts = opts;
+        workers[i].deques = deques;
+        workers[i].index = i;
+        workers[i].count = count;
+    }
+
+    double start = wallSeconds();
+    int started = 0;
+    for (; started < count; started++)
+        if (pthread_create(&workers[started].thread, NULL, workerMain, &workers[started]) != 0) break;
+    // Deques of workers that failed to start get drained by the others' stealing
+    if (started == 0) workerMain(&workers[0]);
+    for (int i = 0; i < started; i++) pthread_join(workers[i].thread, NULL);
+
+    memset(result, 0, sizeof(*result));
+    result->seconds = wallSeconds() - start;
+    for (int i = 0; i < count; i++) {
+        const BatchResult* r = &workers[i].result;
+        result->games += r->games;
+        result->abandoned += r->abandoned;
+        result->steals += r->steals;
+        result->steps += r->steps;
+        result->totalScore += r->totalScore;
+        if (r->bestScore > result->bestScore) result->bestScore = r->bestScore;
+        for (int b = 0; b < BATCH_SCORE_BUCKETS; b++) result->scoreHistogram[b] += r->scoreHistogram[b];
+    }
+
+    free(workers);
+    free(deques);
+    return count;
+}
+
+static int scorePercentile(const BatchResult* r, double p) {
+    unsigned long target = (unsigned long)(r->games * p), seen = 0;
+    for (int b = 0; b < BATCH_SCORE_BUCKETS; b++) {
+        seen += r->scoreHistogram[b];
+        if (seen > target) return b;
+    }
+    return BATCH_SCORE_BUCKETS - 1;
+}
+
+void batchPrint(const BatchResult* r) {
+    double seconds = r->seconds > 0 ? r->seconds : 1e-9;
+    printf("batch: %lu games (+%lu abandoned), %llu steps in %.3f s = %.2f M steps/s, %lu steals\n",
+        r->games, r->abandoned, r->steps, r->seconds, r->steps / seconds / 1e6, r->steals);
+    if (r->games == 0) return;
+    printf("batch: score mean %.2f, p50 %d, p90 %d, p99 %d, best %d\n", (double)r->totalScore / r->games,
+        scorePercentile(r, 0.5), scorePercentile(r, 0.9), scorePercentile(r, 0.99), r->bestScore);
+}
@@ -0,0 +1,37 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "game.h"
+
+/*
+   Plays many independent seeded games across worker threads. Games are
+   dealt out as index ranges, one deque per worker; idle workers steal half
+   of the busiest-looking victim's remaining range.
+*/
+
+#define BATCH_MAX_THREADS 256
+#define BATCH_SCORE_BUCKETS 256 // scores at or above the last bucket are lumped together
+
+typedef GameInput (*Controller)(const GameState* g);
+
+typedef struct {
+    unsigned long games;
+    int threads; // 0 = one per core
+    uint64_t seed; // game i plays seed + i
+    unsigned long maxTicks; // a game still alive after this many ticks is abandoned
+    Controller controller;
+} BatchOptions;
+
+typedef struct {
+    unsigned long games, abandoned, steals;
+    unsigned long long steps, totalScore;
+    int bestScore;
+    unsigned long scoreHistogram[BATCH_SCORE_BUCKETS];
+    double seconds;
+} BatchResult;
+
+int batchRun(const BatchOptions* opts, BatchResult* result);
+void batchPrint(const BatchResult* result);
+int batchCpuCount(void);
+
+#endif
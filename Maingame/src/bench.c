@@ -0,0 +1,562 @@
+#include "bench.h"
+#include "game.h"
+#include "headless.h"
+#include "replay.h"
+#include "scene.h"
+#include <SDL2/SDL_image.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_RECTS 1024 // must be a power of two
+#define COURSE_PIPES 10000
+#define DASH_GAMES 20
+#define DASH_MAX_TICKS 3600 // a game still alive after a minute is ended there
+
+enum {
+    NEEDS_RENDERER = 0x1,
+    NEEDS_FONT = 0x2,
+    NEEDS_CPU = 0x4
+};
+
+typedef struct {
+    // Render target: a software renderer drawing into a plain surface
+    SDL_Surface* target;
+    SDL_Renderer* renderer;
+    Atlas atlas;
+    RotCache rotations;
+    FrameArena arena;
+    TextCache text;
+    DigitStrip digits;
+    TTF_Font* font;
+    RenderBackend sdl;
+    // The CPU renderer compositing into memory, with its own rotation frames;
+    // cpu4k composites the same frames at 3840x2160
+    CpuRenderer cpu, cpu4k;
+    RotCache cpuRotations;
+    RenderBackend cpuBackend, cpu4kBackend;
+    RenderBackend null;
+
+    GameState game, prev;
+    int inMenu;
+    Rect rects[BENCH_RECTS][2];
+    Replay replay;
+    unsigned int replayGame;
+    volatile int sink; // results go here so the work can't be optimized away
+} BenchContext;
+
+typedef struct {
+    const char* name;
+    const char* op;
+    int needs;
+    void (*setup)(BenchContext* c);
+    void (*run)(BenchContext* c, unsigned long iters);
+} Benchmark;
+
+typedef struct {
+    const Benchmark* bench;
+    unsigned long iterations; // per sample
+    double medianNs, minNs;
+} BenchMetric;
+
+/* --- micro --- */
+
+static void setupCollision(BenchContext* c) {
+    // Boxes scattered around the bird so about half the tests hit
+    for (int i = 0; i < BENCH_RECTS; i++) {
+        uint64_t r = rngAt(17, i);
+        Rect pipe = {BIRD_X - PIPE_WIDTH + (int)(r % (BIRD_W + PIPE_WIDTH)), 0, PIPE_WIDTH, 50 + (int)(r >> 32) % PIPE_MAX_HEIGHT};
+        Rect bird = {BIRD_X, (int)(r >> 16) % (WINDOW_HEIGHT - BIRD_H), BIRD_W, BIRD_H};
+        c->rects[i][0] = bird;
+        c->rects[i][1] = pipe;
+    }
+}
+
+static void runCollision(BenchContext* c, unsigned long iters) {
+    int hits = 0;
+    for (unsigned long i = 0; i < iters; i++) {
+        const Rect* r = c->rects[i & (BENCH_RECTS - 1)];
+        hits += checkCollision(r[0], r[1]);
+    }
+    c->sink = hits;
+}
+
+static void setupGame(BenchContext* c) {
+    gameReset(&c->game, 1);
+    c->prev = c->game;
+}
+
+static void runSpawn(BenchContext* c, unsigned long iters) {
+    GameState* g = &c->game;
+    for (unsigned long i = 0; i < iters; i++) {
+        g->pipeTimer = PIPE_SPAWN_TICKS; // the next call spawns
+        g->pipeCount = 0; // keep the ring from filling
+        gameStepSpawn(g);
+    }
+    c->sink = g->pipeCount;
+}
+
+static void runStep(BenchContext* c, unsigned long iters) {
+    GameState* g = &c->game;
+    for (unsigned long i = 0; i < iters; i++)
+        if (gameStep(g, botInput(g)) & GAME_EVENT_DIED) gameReset(g, g->seed + 1);
+    c->sink = g->score;
+}
+
+static const SDL_Color white = {255, 255, 255, 255};
+
+/* A text cache miss: TTF rasterization, texture upload, eviction. */
+static void runTextRender(BenchContext* c, unsigned long iters) {
+    int w = 0, h;
+    for (unsigned long i = 0; i < iters; i++) {
+        textCacheClear(&c->text);
+        textCacheGet(&c->text, c->font, "Score: 1234", white, &w, &h);
+    }
+    c->sink = w;
+}
+
+static void runTextHit(BenchContext* c, unsigned long iters) {
+    int w = 0, h;
+    for (unsigned long i = 0; i < iters; i++) textCacheGet(&c->text, c->font, "Score: ", white, &w, &h);
+    c->sink = w;
+}
+
+static void runDigitStrip(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) {
+        digitStripDraw(&c->digits, c->renderer, 1234, WINDOW_WIDTH / 2, 20);
+        SDL_RenderFlush(c->renderer);
+    }
+}
+
+/* --- macro --- */
+
+/* Bot games, seed after seed, until COURSE_PIPES pipes have spawned. */
+static void runCourse(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) {
+        GameState g;
+        uint64_t seed = 1;
+        unsigned long pipes = 0;
+        gameReset(&g, seed);
+        while (pipes + g.pipeHead + g.pipeCount < COURSE_PIPES) {
+            if (gameStep(&g, botInput(&g)) & GAME_EVENT_DIED) {
+                pipes += g.pipeHead + g.pipeCount; // pipeHead + pipeCount = pipes spawned this game
+                gameReset(&g, ++seed);
+            }
+        }
+        c->sink = (int)seed;
+    }
+}
+
+static void drawBackendFrame(BenchContext* c, RenderBackend* b, float alpha) {
+    arenaReset(&c->arena);
+    b->begin(b);
+    sceneDrawSprites(b, c->inMenu, &c->game, &c->prev, alpha);
+    sceneDrawText(b, c->inMenu, &c->game);
+    b->flush(b);
+    b->present(b);
+}
+
+static void drawFrame(BenchContext* c, float alpha) {
+    drawBackendFrame(c, &c->sdl, alpha);
+}
+
+static void rewindReplay(Replay* r) {
+    // Recorded in memory, so there's no seed header to skip
+    r->readPos = 0;
+    r->lastTick = 0;
+    r->dash = 0;
+}
+
+/* Records DASH_GAMES bot games that hold dash for two ticks in three. */
+static void setupDashReplay(BenchContext* c) {
+    replayFree(&c->replay);
+    replayBegin(&c->replay, 1);
+    for (int n = 0; n < DASH_GAMES; n++) {
+        GameState g;
+        gameReset(&g, 1 + n);
+        while (!g.gameOver && g.frame < DASH_MAX_TICKS) {
+            GameInput in = botInput(&g);
+            in.dash = (g.frame / 30) % 3 != 0;
+            replayRecordInput(&c->replay, &g, in);
+            gameStep(&g, in);
+        }
+        replayEndGame(&c->replay, &g);
+    }
+    rewindReplay(&c->replay);
+    c->replayGame = 0;
+    c->inMenu = 0;
+    gameReset(&c->game, c->replay.seed);
+    c->prev = c->game;
+}
+
+/* One tick of the replay and one frame drawn, as the game loop does. */
+static void runDashReplay(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) {
+        GameInput in;
+        int result = replayInput(&c->replay, &c->game, &in);
+        if (result == REPLAY_FINISHED) {
+            rewindReplay(&c->replay);
+            c->replayGame = 0;
+            gameReset(&c->game, c->replay.seed);
+            c->prev = c->game;
+        } else if (result == REPLAY_GAME_OVER || c->game.gameOver) {
+            if (result == REPLAY_STEP) replaySkipGame(&c->replay);
+            gameReset(&c->game, c->replay.seed + ++c->replayGame);
+            c->prev = c->game;
+        } else {
+            c->prev = c->game;
+            gameStep(&c->game, in);
+        }
+        drawFrame(c, 0.5f);
+    }
+}
+
+static void setupMenu(BenchContext* c) {
+    setupGame(c);
+    c->inMenu = 1;
+}
+
+/* The menu loop with nothing happening: drain events, draw, present. */
+static void runMenuIdle(BenchContext* c, unsigned long iters) {
+    SDL_Event e;
+    for (unsigned long i = 0; i < iters; i++) {
+        while (SDL_PollEvent(&e)) {}
+        drawFrame(c, 0.0f);
+    }
+}
+
+/* --- render --- */
+
+/* A bot game stepped to a busy moment: several pipes on screen, bird mid-flap. */
+static void setupBusyGame(BenchContext* c) {
+    c->inMenu = 0;
+    for (uint64_t seed = 1;; seed++) {
+        gameReset(&c->game, seed);
+        while (!c->game.gameOver && c->game.pipeCount < 8) {
+            c->prev = c->game;
+            gameStep(&c->game, botInput(&c->game));
+        }
+        if (!c->game.gameOver) break;
+    }
+}
+
+static void setupDashFrame(BenchContext* c) {
+    setupBusyGame(c);
+    c->game.dashing = 1;
+}
+
+static void setupGameOverFrame(BenchContext* c) {
+    setupBusyGame(c);
+    c->game.gameOver = 1;
+}
+
+/* The busy frame with the bird rotated as a quad instead of copied from the rotation cache. */
+static void setupNativeRotation(BenchContext* c) {
+    setupBusyGame(c);
+    c->sdl.rotations = NULL;
+}
+
+static void runFrame(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) drawFrame(c, 0.5f);
+}
+
+static void setupCpuFrame(BenchContext* c) {
+    setupBusyGame(c);
+    blitKernelsInit(&c->cpu.kernels, BLIT_AUTO);
+    c->cpu.threads = c->cpu.workerCount + 1;
+}
+
+static void setupCpuFrameScalar(BenchContext* c) {
+    setupBusyGame(c);
+    blitKernelsInit(&c->cpu.kernels, BLIT_SCALAR);
+}
+
+static void setupCpuFrameOneThread(BenchContext* c) {
+    setupBusyGame(c);
+    blitKernelsInit(&c->cpu.kernels, BLIT_AUTO);
+    c->cpu.threads = 1;
+}
+
+static void setupCpu4kFrame(BenchContext* c) {
+    setupBusyGame(c);
+    c->cpu4k.threads = c->cpu4k.workerCount + 1;
+}
+
+static void setupCpu4kFrameOneThread(BenchContext* c) {
+    setupBusyGame(c);
+    c->cpu4k.threads = 1;
+}
+
+/* The busy frame recorded and composited by the CPU renderer; nothing is uploaded. */
+static void runCpuFrame(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) drawBackendFrame(c, &c->cpuBackend, 0.5f);
+}
+
+static void runCpu4kFrame(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) drawBackendFrame(c, &c->cpu4kBackend, 0.5f);
+}
+
+/* The busy frame through the null backend: what the scene costs before any drawing. */
+static void runNullFrame(BenchContext* c, unsigned long iters) {
+    for (unsigned long i = 0; i < iters; i++) drawBackendFrame(c, &c->null, 0.5f);
+    c->sink = (int)c->null.sprites;
+}
+
+static const Benchmark benchmarks[] = {
+    {"micro/checkCollision", "call", 0, setupCollision, runCollision},
+    {"micro/spawn", "spawn", 0, setupGame, runSpawn},
+    {"micro/step", "step", 0, setupGame, runStep},
+    {"micro/text_render", "string", NEEDS_RENDERER | NEEDS_FONT, NULL, runTextRender},
+    {"micro/text_cache_hit", "lookup", NEEDS_RENDERER | NEEDS_FONT, NULL, runTextHit},
+    {"micro/digit_strip", "draw", NEEDS_RENDERER | NEEDS_FONT, NULL, runDigitStrip},
+    {"macro/course_10k", "course", 0, NULL, runCourse},
+    {"macro/dash_replay", "frame", NEEDS_RENDERER, setupDashReplay, runDashReplay},
+    {"macro/menu_idle", "frame", NEEDS_RENDERER, setupMenu, runMenuIdle},
+    {"render/null_play", "frame", 0, setupBusyGame, runNullFrame},
+    {"render/play", "frame", NEEDS_RENDERER, setupBusyGame, runFrame},
+    {"render/play_native_rotation", "frame", NEEDS_RENDERER, setupNativeRotation, runFrame},
+    {"render/dash", "frame", NEEDS_RENDERER, setupDashFrame, runFrame},
+    {"render/game_over", "frame", NEEDS_RENDERER, setupGameOverFrame, runFrame},
+    {"render/cpu_play", "frame", NEEDS_RENDERER | NEEDS_CPU, setupCpuFrame, runCpuFrame},
+    {"render/cpu_play_scalar", "frame", NEEDS_RENDERER | NEEDS_CPU, setupCpuFrameScalar, runCpuFrame},
+    {"render/cpu_play_1thread", "frame", NEEDS_RENDERER | NEEDS_CPU, setupCpuFrameOneThread, runCpuFrame},
+    {"render/cpu_play_4k", "frame", NEEDS_RENDERER | NEEDS_CPU, setupCpu4kFrame, runCpu4kFrame},
+    {"render/cpu_play_4k_1thread", "frame", NEEDS_RENDERER | NEEDS_CPU, setupCpu4kFrameOneThread, runCpu4kFrame},
+};
+#define BENCH_COUNT ((int)(sizeof(benchmarks) / sizeof(benchmarks[0])))
+
+/* Software renderer into a window-sized surface, so no window or GPU is needed. */
+static int openRenderer(BenchContext* c) {
+    if (!SDL_getenv("SDL_VIDEODRIVER")) SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) { printf("bench: SDL_Init failed: %s\n", SDL_GetError()); return -1; }
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) printf("bench: IMG_Init failed: %s\n", IMG_GetError());
+    if (TTF_Init() == -1) printf("bench: TTF_Init failed: %s\n", TTF_GetError());
+
+    c->target = SDL_CreateRGBSurfaceWithFormat(0, WINDOW_WIDTH, WINDOW_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    c->renderer = c->target ? SDL_CreateSoftwareRenderer(c->target) : NULL;
+    if (!c->renderer) { printf("bench: can't create a software renderer: %s\n", SDL_GetError()); return -1; }
+
+    atlasLoad(&c->atlas, c->renderer, NULL, ATLAS_KEEP_PIXELS);
+    rotCacheInit(&c->rotations, c->renderer, &c->atlas); // the game's choice on the software renderer
+    if (cpuInit(&c->cpu, NULL, &c->atlas, WINDOW_WIDTH, WINDOW_HEIGHT, BLIT_AUTO, 0) == 0 &&
+        cpuInit(&c->cpu4k, NULL, &c->atlas, WINDOW_WIDTH * 3, WINDOW_HEIGHT * 3, BLIT_AUTO, 0) == 0)
+        rotCacheInit(&c->cpuRotations, NULL, &c->atlas);
+    else
+        cpuFree(&c->cpu);
+    atlasReleasePixels(&c->atlas);
+    c->font = TTF_OpenFont("assets/fonts/Fraktur.ttf", 48);
+    if (!c->font) printf("bench: can't load font, skipping text benchmarks: %s\n", TTF_GetError());
+    textCacheInit(&c->text, c->renderer);
+    digitStripInit(&c->digits, c->renderer, c->font, white);
+    backendInitSdl(&c->sdl, c->renderer, &c->atlas, NULL, &c->arena, &c->text, &c->digits, c->font);
+    if (c->cpu.frame) {
+        cpuDigitsInit(&c->cpu, c->font);
+        cpuDigitsInit(&c->cpu4k, c->font);
+        backendInitCpu(&c->cpuBackend, &c->cpu, &c->atlas, &c->cpuRotations, c->font);
+        backendInitCpu(&c->cpu4kBackend, &c->cpu4k, &c->atlas, &c->cpuRotations, c->font);
+    }
+    return 0;
+}
+
+static void closeRenderer(BenchContext* c) {
+    textCacheClear(&c->text);
+    digitStripFree(&c->digits);
+    if (c->font) TTF_CloseFont(c->font);
+    if (c->renderer) {
+        atlasDestroy(&c->atlas);
+        rotCacheFree(&c->rotations);
+        rotCacheFree(&c->cpuRotations);
+        cpuFree(&c->cpu);
+        cpuFree(&c->cpu4k);
+        SDL_DestroyRenderer(c->renderer);
+    }
+    if (c->target) SDL_FreeSurface(c->target);
+    TTF_Quit();
+    IMG_Quit();
+    SDL_Quit();
+}
+
+static double timeRun(BenchContext* c, const Benchmark* b, unsigned long iters) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    b->run(c, iters);
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* Doubles the iteration count until a run takes a quarter of a sample
+   (which also warms caches), scales it to a full sample, then samples. */
+static void measure(BenchContext* c, const Benchmark* b, int samples, double sampleSeconds, BenchMetric* m) {
+    c->sdl.rotations = c->rotations.texture ? &c->rotations : NULL; // setups may turn it off
+    if (b->setup) b->setup(c);
+    unsigned long iters = 1;
+    double t;
+    while ((t = timeRun(c, b, iters)) < sampleSeconds / 4 && iters < (1UL << 30)) iters *= 2;
+    if (t > 0) iters = (unsigned long)(iters * sampleSeconds / t);
+    if (iters < 1) iters = 1;
+
+    double ns[BENCH_SAMPLES];
+    for (int s = 0; s < samples; s++) ns[s] = timeRun(c, b, iters) * 1e9 / iters;
+    qsort(ns, samples, sizeof(double), compareDoubles);
+    m->bench = b;
+    m->iterations = iters;
+    m->medianNs = ns[samples / 2];
+    m->minNs = ns[0];
+}
+
+static const char* formatNs(double ns, char* buf, size_t size) {
+    if (ns < 1e3) snprintf(buf, size, "%.2f ns", ns);
+    else if (ns < 1e6) snprintf(buf, size, "%.2f us", ns / 1e3);
+    else snprintf(buf, size, "%.2f ms", ns / 1e6);
+    return buf;
+}
+
+static int writeJson(const char* path, const BenchMetric* metrics, int count) {
+    FILE* f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "{\n  \"suite\": \"froppy-bench\",\n  \"results\": [\n");
+    for (int i = 0; i < count; i++) {
+        const BenchMetric* m = &metrics[i];
+        fprintf(f, "    {\"name\": \"%s\", \"op\": \"%s\", \"iterations\": %lu, \"median_ns\": %.3f, \"min_ns\": %.3f}%s\n",
+            m->bench->name, m->bench->op, m->iterations, m->medianNs, m->minNs, i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+static char* readFile(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* text = size >= 0 ? malloc(size + 1) : NULL;
+    if (text) text[fread(text, 1, size, f)] = '\0';
+    fclose(f);
+    return text;
+}
+
+/* Finds name's median_ns in a file written by writeJson. */
+static int baselineMedian(const char* json, const char* name, double* median) {
+    char key[96];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char* entry = strstr(json, key);
+    if (!entry) return 0;
+    const char* next = strstr(entry + 1, "\"name\":");
+    const char* value = strstr(entry, "\"median_ns\":");
+    if (!value || (next && value > next)) return 0;
+    *median = strtod(value + strlen("\"median_ns\":"), NULL);
+    return *median > 0;
+}
+
+/* Prints each metric against the baseline; returns how many regressed past threshold percent.
+   Baseline entries the filter lets through but that weren't measured (skipped,
+   or gone from the suite) are listed too and counted in missing. */
+static int compareBaseline(const char* path, const BenchMetric* metrics, int count, double threshold,
+    const char* filter, int* missing) {
+    char* json = readFile(path);
+    if (!json) { printf("bench: can't read baseline %s\n", path); return -1; }
+
+    int regressions = 0;
+    char base[32], now[32];
+    printf("\ncompare against %s (threshold +%.1f%%):\n%-24s %12s %12s %9s\n", path, threshold, "benchmark", "baseline", "now", "change");
+    for (int i = 0; i < count; i++) {
+        const BenchMetric* m = &metrics[i];
+        double baseline;
+        if (!baselineMedian(json, m->bench->name, &baseline)) {
+            printf("%-24s %12s %12s %9s\n", m->bench->name, "-", formatNs(m->medianNs, now, sizeof(now)), "new");
+            continue;
+        }
+        double change = (m->medianNs / baseline - 1) * 100;
+        int regressed = change > threshold;
+        regressions += regressed;
+        printf("%-24s %12s %12s %+8.1f%%%s\n", m->bench->name, formatNs(baseline, base, sizeof(base)),
+            formatNs(m->medianNs, now, sizeof(now)), change, regressed ? "  REGRESSED" : "");
+    }
+
+    *missing = 0;
+    const char* key = "\"name\": \"";
+    for (const char* entry = strstr(json, key); entry; entry = strstr(entry, key)) {
+        entry += strlen(key);
+        char name[64];
+        int len = (int)strcspn(entry, "\"");
+        snprintf(name, sizeof(name), "%.*s", len, entry);
+        if (filter && !strstr(name, filter)) continue;
+        int measured = 0;
+        for (int i = 0; i < count && !measured; i++) measured = strcmp(metrics[i].bench->name, name) == 0;
+        double baseline;
+        if (measured || !baselineMedian(json, name, &baseline)) continue;
+        (*missing)++;
+        printf("%-24s %12s %12s %9s\n", name, formatNs(baseline, base, sizeof(base)), "-", "MISSING");
+    }
+    free(json);
+    return regressions;
+}
+
+int runBench(int argc, char* argv[]) {
+    const char* jsonPath = NULL;
+    const char* comparePath = NULL;
+    const char* filter = NULL;
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+    int samples = BENCH_SAMPLES;
+    double sampleSeconds = BENCH_SAMPLE_MS / 1000.0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) jsonPath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) comparePath = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (strcmp(argv[i], "--quick") == 0) { samples = 3; sampleSeconds = 0.01; }
+        else if (strcmp(argv[i], "--list") == 0) {
+            for (int b = 0; b < BENCH_COUNT; b++) printf("%s\n", benchmarks[b].name);
+            return 0;
+        }
+    }
+
+    static BenchContext context;
+    int needs = 0;
+    for (int b = 0; b < BENCH_COUNT; b++)
+        if (!filter || strstr(benchmarks[b].name, filter)) needs |= benchmarks[b].needs;
+    if (arenaInit(&context.arena, FRAME_ARENA_SIZE) != 0) { printf("bench: out of memory\n"); return 1; }
+    backendInitNull(&context.null);
+    int haveRenderer = needs && openRenderer(&context) == 0;
+
+    BenchMetric metrics[BENCH_COUNT];
+    int count = 0;
+    char median[32], best[32];
+    printf("%-24s %12s %12s %12s\n", "benchmark", "median", "min", "iterations");
+    for (int b = 0; b < BENCH_COUNT; b++) {
+        const Benchmark* bench = &benchmarks[b];
+        if (filter && !strstr(bench->name, filter)) continue;
+        if (((bench->needs & NEEDS_RENDERER) && !haveRenderer) || ((bench->needs & NEEDS_FONT) && !context.font) ||
+            ((bench->needs & NEEDS_CPU) && !context.cpu.frame)) {
+            printf("%-24s %12s\n", bench->name, "skipped");
+            continue;
+        }
+        BenchMetric* m = &metrics[count++];
+        measure(&context, bench, samples, sampleSeconds, m);
+        printf("%-24s %12s %12s %12lu  per %s\n", bench->name, formatNs(m->medianNs, median, sizeof(median)),
+            formatNs(m->minNs, best, sizeof(best)), m->iterations, bench->op);
+        fflush(stdout);
+    }
+
+    if (needs) closeRenderer(&context);
+    replayFree(&context.replay);
+    arenaFree(&context.arena);
+
+    if (jsonPath) {
+        if (writeJson(jsonPath, metrics, count) != 0) { printf("bench: can't write %s\n", jsonPath); return 1; }
+        printf("bench: wrote %s\n", jsonPath);
+    }
+    if (comparePath) {
+        int missing;
+        int regressions = compareBaseline(comparePath, metrics, count, threshold, filter, &missing);
+        if (regressions < 0) return 1;
+        printf("bench: %d regression%s, %d missing\n", regressions, regressions == 1 ? "" : "s", missing);
+        return regressions || missing ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+   Benchmark suite in three tiers. micro: the collision test, the spawner,
+   one simulation step and text. macro: a 10k-pipe course, a dash-heavy
+   replay drawn frame by frame, and the idle menu. render: single frames
+   through SDL's software renderer on the dummy video driver (or whatever
+   SDL_VIDEODRIVER says, e.g. offscreen).
+
+   Each benchmark is calibrated to a fixed time per sample and reports the
+   median and minimum of its samples in ns per op. --json FILE writes the
+   results; --compare FILE checks them against a stored baseline and fails
+   when any median is more than --threshold percent (default 10) slower.
+   --filter S runs only the benchmarks whose name contains S, --quick takes
+   fewer and shorter samples, --list prints the names.
+*/
+
+#define BENCH_SAMPLES 7
+#define BENCH_SAMPLE_MS 50
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+/* Returns a process exit code: nonzero when the compare found a regression. */
+int runBench(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,7 @@
+// Benchmark build: the game modules drawn through SDL's software renderer, no window.
+#include <SDL2/SDL.h> // SDL_main on Windows
+#include "bench.h"
+
+int main(int argc, char* argv[]) {
+    return runBench(argc, argv);
+}
@@ -0,0 +1,234 @@
+#include "cpublit.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BLIT_X86 1
+#include <immintrin.h>
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* --- scalar --- */
+
+/* Two channels at a time in the 0x00ff00ff lanes: t / 255, rounded, for t up to 255 * 255. */
+static inline Uint32 div255Pair(Uint32 t) {
+    t += 0x00800080;
+    return ((t + ((t >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+/* a * m / 255 + b * (255 - m) / 255 per channel, rounded once like the SIMD kernels. */
+static inline Uint32 mixPixel(Uint32 a, Uint32 b, Uint32 m) {
+    Uint32 rb = div255Pair((a & 0x00ff00ff) * m + (b & 0x00ff00ff) * (255 - m));
+    Uint32 ag = div255Pair(((a >> 8) & 0x00ff00ff) * m + ((b >> 8) & 0x00ff00ff) * (255 - m));
+    return rb | (ag << 8);
+}
+
+static void blendScalar(Uint32* dst, const Uint32* src, int n) {
+    for (int i = 0; i < n; i++) {
+        Uint32 s = src[i], a = s >> 24;
+        if (a == 255) dst[i] = s;
+        else if (a) dst[i] = s + mixPixel(0, dst[i], a);
+    }
+}
+
+static void glyphScalar(Uint32* dst, const Uint8* mask, int n, Uint32 color) {
+    for (int i = 0; i < n; i++) {
+        Uint32 m = mask[i];
+        if (m == 255) dst[i] = color;
+        else if (m) dst[i] = mixPixel(color, dst[i], m);
+    }
+}
+
+static inline Uint32 lerpPixel(Uint32 a, Uint32 b, Uint32 t) {
+    Uint32 rb = ((a & 0x00ff00ff) * (256 - t) + (b & 0x00ff00ff) * t) >> 8;
+    Uint32 ag = ((a >> 8) & 0x00ff00ff) * (256 - t) + ((b >> 8) & 0x00ff00ff) * t;
+    return (rb & 0x00ff00ff) | (ag & 0xff00ff00);
+}
+
+static void lerpRowsScalar(Uint32* dst, const Uint32* a, const Uint32* b, int n, int t) {
+    for (int i = 0; i < n; i++) dst[i] = lerpPixel(a[i], b[i], (Uint32)t);
+}
+
+void blitLerpColumns(Uint32* dst, const Uint32* src, const int* x, int n) {
+    for (int i = 0; i < n; i++) {
+        const Uint32* p = src + (x[i] >> 16);
+        Uint32 t = (x[i] >> 8) & 0xff;
+        dst[i] = t ? lerpPixel(p[0], p[1], t) : p[0];
+    }
+}
+
+void blitPremultiply(Uint32* dst, const Uint8* rgba, int n) {
+    for (int i = 0; i < n; i++, rgba += 4) {
+        Uint32 a = rgba[3];
+        Uint32 r = (rgba[0] * a + 127) / 255, g = (rgba[1] * a + 127) / 255, b = (rgba[2] * a + 127) / 255;
+        dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+#ifdef BLIT_X86
+
+/* --- SSE2: 4 pixels, each channel in a 16-bit lane --- */
+
+/* x * m / 255 per 16-bit lane, rounded; x * m + 128 fits in 16 bits. */
+TARGET_SSE2 static inline __m128i div255Epi16(__m128i t) {
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+TARGET_SSE2 static inline __m128i alphaEpi16(__m128i p) {
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+TARGET_SSE2 static void blendSse2(Uint32* dst, const Uint32* src, int n) {
+    const __m128i zero = _mm_setzero_si128(), alphaMask = _mm_set1_epi32((int)0xff000000), full = _mm_set1_epi16(255);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff) continue; // all transparent
+        __m128i alpha = _mm_and_si128(s, alphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xffff) { // all opaque
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, alphaEpi16(_mm_unpacklo_epi8(s, zero))));
+        __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, alphaEpi16(_mm_unpackhi_epi8(s, zero))));
+        d = _mm_packus_epi16(div255Epi16(lo), div255Epi16(hi));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_adds_epu8(d, s));
+    }
+    blendScalar(dst + i, src + i, n - i);
+}
+
+TARGET_SSE2 static void glyphSse2(Uint32* dst, const Uint8* mask, int n, Uint32 color) {
+    const __m128i zero = _mm_setzero_si128(), full = _mm_set1_epi16(255);
+    const __m128i c = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), zero);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int bits;
+        memcpy(&bits, mask + i, 4);
+        if (bits == 0) continue;
+        if (bits == -1) { _mm_storeu_si128((__m128i*)(dst + i), _mm_set1_epi32((int)color)); continue; }
+        // Coverage widened to one dword per pixel, then copied into both of its 16-bit halves
+        __m128i m = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero);
+        m = _mm_or_si128(m, _mm_slli_epi32(m, 16));
+        __m128i mlo = _mm_unpacklo_epi32(m, m), mhi = _mm_unpackhi_epi32(m, m);
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(c, mlo), _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_sub_epi16(full, mlo)));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(c, mhi), _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_sub_epi16(full, mhi)));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(div255Epi16(lo), div255Epi16(hi)));
+    }
+    glyphScalar(dst + i, mask + i, n - i, color);
+}
+
+TARGET_SSE2 static void lerpRowsSse2(Uint32* dst, const Uint32* a, const Uint32* b, int n, int t) {
+    const __m128i zero = _mm_setzero_si128(), wa = _mm_set1_epi16((short)(256 - t)), wb = _mm_set1_epi16((short)t);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i pa = _mm_loadu_si128((const __m128i*)(a + i)), pb = _mm_loadu_si128((const __m128i*)(b + i));
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa), _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa), _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    lerpRowsScalar(dst + i, a + i, b + i, n - i, t);
+}
+
+/* --- AVX2: the same, 8 pixels; unpack and pack both work per 128-bit lane, so order is kept --- */
+
+TARGET_AVX2 static inline __m256i div255Epi16x8(__m256i t) {
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+TARGET_AVX2 static void blendAvx2(Uint32* dst, const Uint32* src, int n) {
+    const __m256i zero = _mm256_setzero_si256(), alphaMask = _mm256_set1_epi32((int)0xff000000), full = _mm256_set1_epi16(255);
+    const __m256i alphaShuffle = _mm256_setr_epi8(6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15,
+        6, 7, 6, 7, 6, 7, 6, 7, 14, 15, 14, 15, 14, 15, 14, 15);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        if (_mm256_testz_si256(s, s)) continue;
+        __m256i alpha = _mm256_and_si256(s, alphaMask);
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(alpha, alphaMask)) == -1) {
+            _mm256_storeu_si256((__m256i*)(dst + i), s);
+            continue;
+        }
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i slo = _mm256_unpacklo_epi8(s, zero), shi = _mm256_unpackhi_epi8(s, zero);
+        __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, _mm256_shuffle_epi8(slo, alphaShuffle)));
+        __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, _mm256_shuffle_epi8(shi, alphaShuffle)));
+        d = _mm256_packus_epi16(div255Epi16x8(lo), div255Epi16x8(hi));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_adds_epu8(d, s));
+    }
+    blendSse2(dst + i, src + i, n - i);
+}
+
+TARGET_AVX2 static void glyphAvx2(Uint32* dst, const Uint8* mask, int n, Uint32 color) {
+    const __m256i zero = _mm256_setzero_si256(), full = _mm256_set1_epi16(255);
+    const __m256i c = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        long long bits;
+        memcpy(&bits, mask + i, 8);
+        if (bits == 0) continue;
+        if (bits == -1) { _mm256_storeu_si256((__m256i*)(dst + i), _mm256_set1_epi32((int)color)); continue; }
+        // Lane 0 takes pixels 0-3 and lane 1 pixels 4-7, matching the in-lane unpacks below
+        __m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(mask + i)));
+        m = _mm256_or_si256(m, _mm256_slli_epi32(m, 16));
+        __m256i mlo = _mm256_unpacklo_epi32(m, m), mhi = _mm256_unpackhi_epi32(m, m);
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(c, mlo), _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), _mm256_sub_epi16(full, mlo)));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(c, mhi), _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), _mm256_sub_epi16(full, mhi)));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(div255Epi16x8(lo), div255Epi16x8(hi)));
+    }
+    glyphSse2(dst + i, mask + i, n - i, color);
+}
+
+TARGET_AVX2 static void lerpRowsAvx2(Uint32* dst, const Uint32* a, const Uint32* b, int n, int t) {
+    const __m256i zero = _mm256_setzero_si256(), wa = _mm256_set1_epi16((short)(256 - t)), wb = _mm256_set1_epi16((short)t);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i pa = _mm256_loadu_si256((const __m256i*)(a + i)), pb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(pa, zero), wa), _mm256_mullo_epi16(_mm256_unpacklo_epi8(pb, zero), wb));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(pa, zero), wa), _mm256_mullo_epi16(_mm256_unpackhi_epi8(pb, zero), wb));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+    }
+    lerpRowsSse2(dst + i, a + i, b + i, n - i, t);
+}
+
+#endif
+
+static const char* levelNames[] = {"auto", "scalar", "sse2", "avx2"};
+
+const char* blitLevelName(int level) {
+    return level >= BLIT_AUTO && level <= BLIT_AVX2 ? levelNames[level] : "?";
+}
+
+int blitLevelByName(const char* name) {
+    for (int i = BLIT_AUTO; i <= BLIT_AVX2; i++)
+        if (strcmp(name, levelNames[i]) == 0) return i;
+    return -1;
+}
+
+void blitKernelsInit(BlitKernels* k, int level) {
+    int cap = level == BLIT_AUTO ? BLIT_AVX2 : level;
+    k->level = BLIT_SCALAR;
+    k->blend = blendScalar;
+    k->glyph = glyphScalar;
+    k->lerpRows = lerpRowsScalar;
+#ifdef BLIT_X86
+    if (cap >= BLIT_SSE2 && SDL_HasSSE2()) {
+        k->level = BLIT_SSE2;
+        k->blend = blendSse2;
+        k->glyph = glyphSse2;
+        k->lerpRows = lerpRowsSse2;
+    }
+    if (cap >= BLIT_AVX2 && SDL_HasAVX2()) {
+        k->level = BLIT_AVX2;
+        k->blend = blendAvx2;
+        k->glyph = glyphAvx2;
+        k->lerpRows = lerpRowsAvx2;
+    }
+#else
+    (void)cap;
+#endif
+}
@@ -0,0 +1,41 @@
+#ifndef CPUBLIT_H
+#define CPUBLIT_H
+
+#include <SDL2/SDL.h>
+
+/*
+   Row kernels for the CPU renderer. Pixels are premultiplied ARGB8888
+   words; the destination is opaque. Each kernel has a scalar version and,
+   on x86, SSE2 and AVX2 versions picked at runtime from what the CPU has.
+*/
+
+enum {
+    BLIT_AUTO,
+    BLIT_SCALAR,
+    BLIT_SSE2,
+    BLIT_AVX2
+};
+
+typedef struct {
+    int level; // what was picked, BLIT_SCALAR..BLIT_AVX2
+    /* src over dst. */
+    void (*blend)(Uint32* dst, const Uint32* src, int n);
+    /* color (opaque) over dst, weighted by 8-bit coverage. */
+    void (*glyph)(Uint32* dst, const Uint8* mask, int n, Uint32 color);
+    /* dst = a + (b - a) * t / 256, t in 0..256. */
+    void (*lerpRows)(Uint32* dst, const Uint32* a, const Uint32* b, int n, int t);
+} BlitKernels;
+
+/* Picks the best level the CPU supports, capped at level (BLIT_AUTO: no cap). */
+void blitKernelsInit(BlitKernels* k, int level);
+const char* blitLevelName(int level);
+/* "scalar", "sse2", "avx2" or "auto"; -1 when unknown. */
+int blitLevelByName(const char* name);
+
+/* dst[i] = src[x[i] >> 16] blended horizontally with its right neighbour by
+   bits 8..15 of x[i], i.e. positions in 16.16 fixed point. */
+void blitLerpColumns(Uint32* dst, const Uint32* src, const int* x, int n);
+/* RGBA32 bytes with straight alpha to premultiplied ARGB8888. */
+void blitPremultiply(Uint32* dst, const Uint8* rgba, int n);
+
+#endif
@@ -0,0 +1,333 @@
+#include "cpurender.h"
+#include "game.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Window coordinate to output pixel, rounding down for negative ones too. */
+static int toOutput(int v, int outSize, int windowSize) {
+    long long p = (long long)v * outSize;
+    return (int)(p >= 0 ? p / windowSize : -((-p + windowSize - 1) / windowSize));
+}
+
+static SDL_Rect outputRect(const CpuRenderer* c, const SDL_Rect* r) {
+    int x0 = toOutput(r->x, c->w, WINDOW_WIDTH), y0 = toOutput(r->y, c->h, WINDOW_HEIGHT);
+    int x1 = toOutput(r->x + r->w, c->w, WINDOW_WIDTH), y1 = toOutput(r->y + r->h, c->h, WINDOW_HEIGHT);
+    return (SDL_Rect){x0, y0, x1 - x0, y1 - y0};
+}
+
+static int scratchInit(CpuScratch* s, int w) {
+    s->row = malloc(sizeof(Uint32) * w);
+    s->span = malloc(sizeof(Uint32) * CPU_MAX_SOURCE_W);
+    s->x = malloc(sizeof(int) * w);
+    s->coverage = malloc(w);
+    return s->row && s->span && s->x && s->coverage ? 0 : -1;
+}
+
+static void scratchFree(CpuScratch* s) {
+    free(s->row);
+    free(s->span);
+    free(s->x);
+    free(s->coverage);
+    memset(s, 0, sizeof(*s));
+}
+
+static void compositeRegion(const CpuRenderer* c, const SDL_Rect* clip, CpuScratch* s);
+
+/* Takes tiles until there are none left. */
+static void compositeTiles(CpuRenderer* c, CpuScratch* s) {
+    int t;
+    while ((t = SDL_AtomicAdd(&c->nextTile, 1)) < c->tileCount) {
+        int y = t * c->tileRows;
+        SDL_Rect tile = {0, y, c->w, SDL_min(c->tileRows, c->h - y)};
+        compositeRegion(c, &tile, s);
+    }
+}
+
+static int workerMain(void* data) {
+    CpuWorker* w = data;
+    CpuRenderer* c = w->renderer;
+    for (;;) {
+        SDL_SemWait(c->start);
+        if (SDL_AtomicGet(&c->quit)) return 0;
+        compositeTiles(c, &w->scratch);
+        SDL_SemPost(c->done);
+    }
+}
+
+/* Starts up to threads - 1 workers; fewer if threads can't be made. */
+static void startWorkers(CpuRenderer* c, int threads) {
+    c->start = SDL_CreateSemaphore(0);
+    c->done = SDL_CreateSemaphore(0);
+    if (!c->start || !c->done) return;
+    while (c->workerCount < threads - 1) {
+        CpuWorker* w = &c->workers[c->workerCount];
+        w->renderer = c;
+        if (scratchInit(&w->scratch, c->w) != 0) { scratchFree(&w->scratch); break; }
+        w->thread = SDL_CreateThread(workerMain, "cpu compositor", w);
+        if (!w->thread) { scratchFree(&w->scratch); break; }
+        c->workerCount++;
+    }
+}
+
+/* The bg is drawn over the whole window every frame; scaling it once turns
+   that into a copy. Composited through the frame like any other draw. */
+static void prescaleBackground(CpuRenderer* c) {
+    SDL_Rect screen = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT}, all = {0, 0, c->w, c->h};
+    if (!c->loaded[SPRITE_BG] || (c->w == WINDOW_WIDTH && c->h == WINDOW_HEIGHT)) return;
+    if (!(c->background = malloc(sizeof(Uint32) * c->w * c->h))) return;
+    cpuBegin(c);
+    cpuSprite(c, SPRITE_BG, &screen);
+    compositeRegion(c, &all, &c->scratch);
+    memcpy(c->background, c->frame, sizeof(Uint32) * c->w * c->h);
+    c->drawCount = 0;
+}
+
+int cpuInit(CpuRenderer* c, SDL_Renderer* renderer, const Atlas* a, int w, int h, int simd, int threads) {
+    memset(c, 0, sizeof(*c));
+    if (!a->pixels) return -1;
+    c->renderer = renderer;
+    c->w = w;
+    c->h = h;
+    c->filter = w == WINDOW_WIDTH && h == WINDOW_HEIGHT ? CPU_FILTER_NEAREST : CPU_FILTER_BILINEAR;
+    blitKernelsInit(&c->kernels, simd);
+
+    c->frame = malloc(sizeof(Uint32) * w * h);
+    c->atlas = malloc(sizeof(Uint32) * a->w * a->h);
+    if (!c->frame || !c->atlas || scratchInit(&c->scratch, w) != 0) { cpuFree(c); return SDL_OutOfMemory(); }
+    c->atlasPitch = a->w;
+    c->atlasH = a->h;
+    for (int y = 0; y < a->h; y++)
+        blitPremultiply(c->atlas + y * a->w, (const Uint8*)a->pixels->pixels + y * a->pixels->pitch, a->w);
+    memcpy(c->regions, a->regions, sizeof(c->regions));
+    memcpy(c->loaded, a->loaded, sizeof(c->loaded));
+    prescaleBackground(c);
+
+    if (threads <= 0) threads = SDL_GetCPUCount();
+    startWorkers(c, SDL_clamp(threads, 1, CPU_MAX_THREADS));
+    c->threads = c->workerCount + 1;
+
+    if (renderer) {
+        c->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (!c->texture) { cpuFree(c); return -1; }
+        SDL_SetTextureBlendMode(c->texture, SDL_BLENDMODE_NONE);
+    }
+    logInfo("cpu renderer", logInt("w", w), logInt("h", h), logStr("simd", blitLevelName(c->kernels.level)),
+        logStr("filter", c->filter == CPU_FILTER_BILINEAR ? "bilinear" : "nearest"), logInt("threads", c->threads));
+    return 0;
+}
+
+static void freeText(CpuText* t) {
+    free(t->coverage);
+    memset(t, 0, sizeof(*t));
+}
+
+void cpuFree(CpuRenderer* c) {
+    SDL_AtomicSet(&c->quit, 1);
+    for (int i = 0; i < c->workerCount; i++) SDL_SemPost(c->start);
+    for (int i = 0; i < c->workerCount; i++) {
+        SDL_WaitThread(c->workers[i].thread, NULL);
+        scratchFree(&c->workers[i].scratch);
+    }
+    if (c->start) SDL_DestroySemaphore(c->start);
+    if (c->done) SDL_DestroySemaphore(c->done);
+    if (c->texture) SDL_DestroyTexture(c->texture);
+    free(c->frame);
+    free(c->background);
+    free(c->atlas);
+    scratchFree(&c->scratch);
+    for (int i = 0; i < CPU_TEXT_CACHE; i++) freeText(&c->texts[i]);
+    for (int i = 0; i < 10; i++) freeText(&c->digits[i]);
+    memset(c, 0, sizeof(*c));
+}
+
+void cpuBegin(CpuRenderer* c) {
+    c->drawCount = 0;
+}
+
+static void record(CpuRenderer* c, int kind, const void* pixels, int pitch, const SDL_Rect* src, const SDL_Rect* dst, Uint32 color) {
+    if (c->drawCount >= CPU_MAX_DRAWS || src->w <= 0 || src->h <= 0) return;
+    SDL_Rect out = outputRect(c, dst);
+    if (out.w <= 0 || out.h <= 0 || (src->w > CPU_MAX_SOURCE_W && src->w != out.w)) return;
+    c->draws[c->drawCount++] = (CpuDraw){kind, pixels, pitch, *src, out, color};
+}
+
+void cpuSprite(CpuRenderer* c, int sprite, const SDL_Rect* dst) {
+    if (!c->loaded[sprite]) return;
+    if (sprite == SPRITE_BG && c->background && dst->x == 0 && dst->y == 0 && dst->w == WINDOW_WIDTH && dst->h == WINDOW_HEIGHT) {
+        SDL_Rect src = {0, 0, c->w, c->h};
+        record(c, CPU_DRAW_COPY, c->background, c->w, &src, dst, 0);
+        return;
+    }
+    int kind = sprite == SPRITE_BG ? CPU_DRAW_COPY : CPU_DRAW_BLEND;
+    record(c, kind, c->atlas, c->atlasPitch, &c->regions[sprite], dst, 0);
+}
+
+void cpuImage(CpuRenderer* c, const Uint32* pixels, int pitch, const SDL_Rect* src, const SDL_Rect* dst) {
+    record(c, CPU_DRAW_BLEND, pixels, pitch, src, dst, 0);
+}
+
+/* Shaded text is 8-bit palettized, black to white, so the palette's red is the coverage. */
+static int rasterize(CpuText* t, TTF_Font* font, const char* text) {
+    const SDL_Color white = {255, 255, 255, 255}, black = {0, 0, 0, 255};
+    SDL_Surface* surf = TTF_RenderText_Shaded(font, text, white, black);
+    if (!surf) return -1;
+    t->coverage = malloc((size_t)surf->w * surf->h);
+    if (t->coverage && surf->format->palette) {
+        const SDL_Color* colors = surf->format->palette->colors;
+        for (int y = 0; y < surf->h; y++) {
+            const Uint8* in = (const Uint8*)surf->pixels + y * surf->pitch;
+            for (int x = 0; x < surf->w; x++) t->coverage[y * surf->w + x] = colors[in[x]].r;
+        }
+    }
+    t->w = surf->w;
+    t->h = surf->h;
+    SDL_FreeSurface(surf);
+    if (!t->coverage) return -1;
+    snprintf(t->text, sizeof(t->text), "%s", text);
+    t->font = font;
+    return 0;
+}
+
+const CpuText* cpuText(CpuRenderer* c, TTF_Font* font, const char* text) {
+    if (!font || strlen(text) >= TEXT_CACHE_MAX_LEN) return NULL;
+    c->clock++;
+    CpuText* victim = &c->texts[0];
+    for (int i = 0; i < CPU_TEXT_CACHE; i++) {
+        CpuText* t = &c->texts[i];
+        if (t->lastUsed && t->font == font && strcmp(t->text, text) == 0) {
+            t->lastUsed = c->clock;
+            return t;
+        }
+        if (t->lastUsed < victim->lastUsed) victim = t;
+    }
+    freeText(victim);
+    if (rasterize(victim, font, text) != 0) { freeText(victim); return NULL; }
+    victim->lastUsed = c->clock;
+    return victim;
+}
+
+void cpuDrawText(CpuRenderer* c, const CpuText* t, int x, int y, SDL_Color color) {
+    if (!t) return;
+    SDL_Rect src = {0, 0, t->w, t->h}, dst = {x, y, t->w, t->h};
+    record(c, CPU_DRAW_GLYPH, t->coverage, t->w, &src, &dst, 0xff000000u | (Uint32)color.r << 16 | (Uint32)color.g << 8 | color.b);
+}
+
+int cpuDigitsInit(CpuRenderer* c, TTF_Font* font) {
+    if (!font) return -1;
+    for (int i = 0; i < 10; i++) {
+        char text[2] = {(char)('0' + i), '\0'};
+        if (rasterize(&c->digits[i], font, text) != 0) return -1;
+    }
+    return 0;
+}
+
+int cpuNumberWidth(const CpuRenderer* c, int value) {
+    char text[16];
+    int w = 0;
+    snprintf(text, sizeof(text), "%d", value > 0 ? value : 0);
+    for (const char* p = text; *p; p++) w += c->digits[*p - '0'].w;
+    return w;
+}
+
+void cpuNumber(CpuRenderer* c, int value, int x, int y, SDL_Color color) {
+    char text[16];
+    snprintf(text, sizeof(text), "%d", value > 0 ? value : 0);
+    for (const char* p = text; *p; p++) {
+        const CpuText* t = &c->digits[*p - '0'];
+        if (t->coverage) cpuDrawText(c, t, x, y, color);
+        x += t->w;
+    }
+}
+
+/* One draw, clipped to clip, a row at a time. Source positions are 16.16 at
+   output texel centres; bilinear filtering shifts them back half a texel. */
+static void compositeDraw(const CpuRenderer* c, const CpuDraw* d, const SDL_Rect* clip, CpuScratch* s) {
+    SDL_Rect r;
+    if (!SDL_IntersectRect(&d->dst, clip, &r)) return;
+    int bilinear = c->filter == CPU_FILTER_BILINEAR && d->kind != CPU_DRAW_GLYPH;
+    int half = bilinear ? 32768 : 0;
+    int scaledX = d->src.w != d->dst.w, scaledY = d->src.h != d->dst.h;
+    int maxX = (d->src.w - 1) << 16, maxY = (d->src.h - 1) << 16;
+    if (scaledX) {
+        int step = (d->src.w << 16) / d->dst.w;
+        for (int i = 0; i < r.w; i++) {
+            int pos = (r.x - d->dst.x + i) * step + step / 2 - half;
+            s->x[i] = pos < 0 ? 0 : pos > maxX ? maxX : pos;
+        }
+    }
+    int stepY = (d->src.h << 16) / d->dst.h;
+
+    for (int y = r.y; y < r.y + r.h; y++) {
+        Uint32* out = c->frame + (size_t)y * c->w + r.x;
+        int sy = y - d->dst.y, t = 0;
+        if (scaledY) {
+            int pos = sy * stepY + stepY / 2 - half;
+            pos = pos < 0 ? 0 : pos > maxY ? maxY : pos;
+            sy = pos >> 16;
+            t = bilinear ? (pos >> 8) & 0xff : 0;
+        }
+
+        if (d->kind == CPU_DRAW_GLYPH) {
+            const Uint8* m = (const Uint8*)d->pixels + (d->src.y + sy) * d->pitch + d->src.x;
+            if (scaledX) {
+                for (int i = 0; i < r.w; i++) s->coverage[i] = m[s->x[i] >> 16];
+                m = s->coverage;
+            } else {
+                m += r.x - d->dst.x;
+            }
+            c->kernels.glyph(out, m, r.w, d->color);
+            continue;
+        }
+
+        const Uint32* row0 = (const Uint32*)d->pixels + (d->src.y + sy) * d->pitch + d->src.x;
+        const Uint32* row1 = t ? row0 + d->pitch : row0;
+        const Uint32* src;
+        if (!scaledX) {
+            int skip = r.x - d->dst.x;
+            if (t) c->kernels.lerpRows(s->row, row0 + skip, row1 + skip, r.w, t);
+            src = t ? s->row : row0 + skip;
+        } else {
+            const Uint32* line = row0;
+            if (t) {
+                // Filter vertically only the source columns this row reads
+                int first = s->x[0] >> 16, last = (s->x[r.w - 1] >> 16) + 1;
+                if (last > d->src.w - 1) last = d->src.w - 1;
+                c->kernels.lerpRows(s->span + first, row0 + first, row1 + first, last - first + 1, t);
+                line = s->span;
+            }
+            if (bilinear) blitLerpColumns(s->row, line, s->x, r.w);
+            else for (int i = 0; i < r.w; i++) s->row[i] = line[s->x[i] >> 16];
+            src = s->row;
+        }
+        if (d->kind == CPU_DRAW_COPY) memcpy(out, src, sizeof(Uint32) * r.w);
+        else c->kernels.blend(out, src, r.w);
+    }
+}
+
+static void compositeRegion(const CpuRenderer* c, const SDL_Rect* clip, CpuScratch* s) {
+    // Anything the first draw doesn't cover opaquely starts black
+    SDL_Rect covered;
+    int opaque = c->drawCount > 0 && c->draws[0].kind == CPU_DRAW_COPY &&
+        SDL_IntersectRect(&c->draws[0].dst, clip, &covered) && SDL_RectEquals(&covered, clip);
+    if (!opaque) {
+        for (int y = clip->y; y < clip->y + clip->h; y++)
+            for (int x = 0; x < clip->w; x++) c->frame[(size_t)y * c->w + clip->x + x] = 0xff000000u;
+    }
+    for (int i = 0; i < c->drawCount; i++) compositeDraw(c, &c->draws[i], clip, s);
+}
+
+void cpuFlush(CpuRenderer* c) {
+    // A few tiles per thread so a busy tile doesn't leave the others idle
+    int workers = SDL_clamp(c->threads, 1, c->workerCount + 1) - 1;
+    c->tileRows = SDL_max(CPU_MIN_TILE_ROWS, (c->h + (workers + 1) * 4 - 1) / ((workers + 1) * 4));
+    c->tileCount = (c->h + c->tileRows - 1) / c->tileRows;
+    SDL_AtomicSet(&c->nextTile, 0);
+    for (int i = 0; i < workers; i++) SDL_SemPost(c->start);
+    compositeTiles(c, &c->scratch);
+    for (int i = 0; i < workers; i++) SDL_SemWait(c->done);
+    if (!c->texture) return;
+    SDL_UpdateTexture(c->texture, NULL, c->frame, c->w * (int)sizeof(Uint32));
+    SDL_RenderCopy(c->renderer, c->texture, NULL, NULL);
+}
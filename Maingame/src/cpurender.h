@@ -0,0 +1,136 @@
+#ifndef CPURENDER_H
+#define CPURENDER_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "atlas.h"
+#include "cpublit.h"
+#include "textcache.h"
+
+/*
+   Draws the game on the CPU for machines where SDL would fall back to its
+   generic software renderer. A frame is recorded as a list of draws in
+   window coordinates (the same 1280x720 space the game uses), then
+   composited into a premultiplied ARGB8888 framebuffer at the output size
+   with the row kernels in cpublit, and uploaded into one streaming texture
+   that is copied to the window. Sprites come from a premultiplied copy of
+   the atlas; text is drawn from 8-bit coverage masks.
+
+   Sprites drawn at their packed size are plain row copies or blends; others
+   are scaled, nearest or bilinear. Nothing is rotated: rotated sprites come
+   from a RotCache created without a renderer. When the output isn't the
+   window size the background is scaled once at startup, so the largest draw
+   stays a row copy.
+
+   The frame is composited in horizontal tiles by a pool of threads; the
+   caller's thread takes tiles too. Each tile runs only the draws that
+   intersect it, so a tile under a pipe gap doesn't touch the pipe.
+*/
+
+#define CPU_MAX_DRAWS 256
+#define CPU_MAX_SOURCE_W 2048 // widest source region a draw may scale from
+#define CPU_TEXT_CACHE 8
+#define CPU_MAX_THREADS 16
+#define CPU_MIN_TILE_ROWS 16
+
+enum {
+    CPU_FILTER_NEAREST,
+    CPU_FILTER_BILINEAR
+};
+
+enum {
+    CPU_DRAW_COPY, // opaque source
+    CPU_DRAW_BLEND,
+    CPU_DRAW_GLYPH // coverage mask in one colour
+};
+
+typedef struct {
+    int kind;
+    const void* pixels; // Uint32 premultiplied ARGB, or Uint8 coverage for glyphs
+    int pitch; // in pixels
+    SDL_Rect src;
+    SDL_Rect dst; // in output pixels
+    Uint32 color;
+} CpuDraw;
+
+typedef struct {
+    char text[TEXT_CACHE_MAX_LEN];
+    TTF_Font* font;
+    Uint8* coverage;
+    int w, h;
+    unsigned long lastUsed; // 0 = empty slot
+} CpuText;
+
+/* Per-row working memory for compositing a region. */
+typedef struct {
+    Uint32* row; // output width
+    Uint32* span; // a filtered source row, up to CPU_MAX_SOURCE_W
+    int* x; // output width, source positions in 16.16
+    Uint8* coverage; // output width
+} CpuScratch;
+
+struct CpuRenderer;
+
+typedef struct {
+    struct CpuRenderer* renderer;
+    SDL_Thread* thread;
+    CpuScratch scratch;
+} CpuWorker;
+
+typedef struct CpuRenderer {
+    SDL_Renderer* renderer; // NULL: composite only, nothing is uploaded
+    SDL_Texture* texture;
+    int w, h; // output size
+    Uint32* frame; // w * h
+    int filter;
+    BlitKernels kernels;
+    CpuScratch scratch;
+    Uint32* background; // the bg sprite at the output size, or NULL
+
+    // Tiles are handed out from nextTile; start wakes the workers, done counts them back
+    CpuWorker workers[CPU_MAX_THREADS - 1];
+    int workerCount;
+    int threads; // compositing threads per frame, 1..workerCount + 1
+    int tileRows, tileCount;
+    SDL_atomic_t nextTile;
+    SDL_atomic_t quit;
+    SDL_sem* start;
+    SDL_sem* done;
+
+    Uint32* atlas; // premultiplied copy of the atlas pixels
+    int atlasPitch, atlasH;
+    SDL_Rect regions[SPRITE_COUNT];
+    int loaded[SPRITE_COUNT];
+
+    CpuDraw draws[CPU_MAX_DRAWS];
+    int drawCount;
+
+    CpuText texts[CPU_TEXT_CACHE];
+    unsigned long clock;
+    CpuText digits[10]; // the score, rasterized once
+} CpuRenderer;
+
+/* Needs a->pixels (ATLAS_KEEP_PIXELS). w x h is the output size; renderer may
+   be NULL to composite without presenting. simd is a BLIT_ level, BLIT_AUTO
+   for the best the CPU has. threads is how many threads composite a frame,
+   0 for one per core. Returns 0 on success. */
+int cpuInit(CpuRenderer* c, SDL_Renderer* renderer, const Atlas* a, int w, int h, int simd, int threads);
+void cpuFree(CpuRenderer* c);
+
+void cpuBegin(CpuRenderer* c);
+void cpuSprite(CpuRenderer* c, int sprite, const SDL_Rect* dst);
+/* Premultiplied ARGB pixels, e.g. a RotCache cell. */
+void cpuImage(CpuRenderer* c, const Uint32* pixels, int pitch, const SDL_Rect* src, const SDL_Rect* dst);
+
+/* Coverage mask for text, rasterized on a miss (NULL on failure). */
+const CpuText* cpuText(CpuRenderer* c, TTF_Font* font, const char* text);
+void cpuDrawText(CpuRenderer* c, const CpuText* t, int x, int y, SDL_Color color);
+/* The digits, for cpuNumber; rasterized once so the score never misses. */
+int cpuDigitsInit(CpuRenderer* c, TTF_Font* font);
+int cpuNumberWidth(const CpuRenderer* c, int value);
+void cpuNumber(CpuRenderer* c, int value, int x, int y, SDL_Color color);
+
+/* Composites the whole frame on the pool, uploads it and copies it to the renderer. */
+void cpuFlush(CpuRenderer* c);
+
+#endif
@@ -0,0 +1,133 @@
+#include "flightrec.h"
+#include "allocstats.h"
+#include "log.h"
+#include <string.h>
+
+static int writerMain(void* arg);
+
+void flightInit(FlightRecorder* r, double budgetMs) {
+    memset(r, 0, sizeof(*r));
+    r->budgetMs = budgetMs;
+    r->lastAllocs = allocStatsCount();
+    if (budgetMs <= 0) return;
+    r->wake = SDL_CreateSemaphore(0);
+    if (r->wake) r->writer = SDL_CreateThread(writerMain, "hitch writer", r);
+    if (!r->writer) logWarn("can't start hitch writer, dumping on the game thread", logStr("error", SDL_GetError()));
+}
+
+void flightShutdown(FlightRecorder* r) {
+    if (r->writer) {
+        atomic_store(&r->stop, 1);
+        SDL_SemPost(r->wake);
+        SDL_WaitThread(r->writer, NULL);
+        r->writer = NULL;
+    }
+    if (r->wake) SDL_DestroySemaphore(r->wake);
+    r->wake = NULL;
+}
+
+static void writeSummary(const FlightRecorder* r, FILE* f) {
+    const FlightFrame* frames = r->snapshot;
+    unsigned long n = r->snapshotCount;
+    const FlightFrame* hitch = &frames[n - 1];
+    double avg[PHASE_COUNT] = {0}, avgFrame = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        for (int k = 0; k < PHASE_COUNT; k++) avg[k] += frames[i].phaseUs[k] / 1000.0 / n;
+        avgFrame += frames[i].frameUs / 1000.0 / n;
+    }
+
+    fprintf(f, "hitch at frame %u: %.3f ms (budget %.3f ms), %lu frames of history\n\n",
+        (unsigned)hitch->frame, hitch->frameUs / 1000.0, r->budgetMs, n);
+    fprintf(f, "%-10s %9s %9s\n", "phase", "hitch ms", "avg ms");
+    for (int k = 0; k < PHASE_COUNT; k++)
+        fprintf(f, "%-10s %9.3f %9.3f\n", profPhaseName(k), hitch->phaseUs[k] / 1000.0, avg[k]);
+    fprintf(f, "%-10s %9.3f %9.3f\n\n", "frame", hitch->frameUs / 1000.0, avgFrame);
+
+    fprintf(f, "last frames:\n%8s %9s %7s %6s %6s %6s %7s\n", "frame", "ms", "events", "ticks", "pipes", "flags", "allocs");
+    for (unsigned long i = n < 20 ? 0 : n - 20; i < n; i++) {
+        const FlightFrame* fr = &frames[i];
+        fprintf(f, "%8u %9.3f %7u %6u %6u %6x %7u\n", (unsigned)fr->frame, fr->frameUs / 1000.0,
+            (unsigned)fr->sdlEvents, (unsigned)fr->ticks, (unsigned)fr->pipes, (unsigned)fr->gameEvents, (unsigned)fr->allocs);
+    }
+}
+
+/* Writes the snapshot out; runs on the writer thread. */
+static void writeDump(const FlightRecorder* r) {
+    const FlightFrame* hitch = &r->snapshot[r->snapshotCount - 1];
+    char path[64];
+
+    snprintf(path, sizeof(path), "hitch_%u.fbh", (unsigned)hitch->frame);
+    FILE* f = fopen(path, "wb");
+    if (!f) { logError("can't write hitch dump", logStr("path", path)); return; }
+    Uint32 header[4] = {sizeof(FlightFrame), (Uint32)r->snapshotCount, (Uint32)(r->budgetMs * 1000), PHASE_COUNT};
+    fwrite("FBH1", 1, 4, f);
+    fwrite(header, sizeof(header), 1, f);
+    fwrite(r->snapshot, sizeof(FlightFrame), r->snapshotCount, f);
+    fclose(f);
+
+    snprintf(path, sizeof(path), "hitch_%u.txt", (unsigned)hitch->frame);
+    f = fopen(path, "w");
+    if (f) {
+        writeSummary(r, f);
+        fclose(f);
+    }
+    logWarn("hitch recorded", logInt("frame", hitch->frame), logNum("ms", hitch->frameUs / 1000.0), logStr("dump", path));
+}
+
+static int writerMain(void* arg) {
+    FlightRecorder* r = arg;
+    for (;;) {
+        SDL_SemWait(r->wake);
+        if (atomic_load(&r->pending)) {
+            writeDump(r);
+            atomic_store(&r->pending, 0);
+        }
+        if (atomic_load(&r->stop)) return 0;
+    }
+}
+
+/* Copies the ring, oldest first, into the snapshot and hands it to the writer. */
+static int dump(FlightRecorder* r) {
+    if (atomic_load(&r->pending)) return 0; // still writing the last one
+    unsigned long first = r->count > FLIGHT_FRAMES ? r->count - FLIGHT_FRAMES : 0;
+    unsigned long start = first % FLIGHT_FRAMES, n = r->count - first;
+    unsigned long wrap = n < FLIGHT_FRAMES - start ? n : FLIGHT_FRAMES - start;
+    memcpy(r->snapshot, &r->frames[start], wrap * sizeof(FlightFrame));
+    memcpy(r->snapshot + wrap, r->frames, (n - wrap) * sizeof(FlightFrame));
+    r->snapshotCount = n;
+    if (!r->writer) { writeDump(r); return 1; }
+    atomic_store(&r->pending, 1);
+    SDL_SemPost(r->wake);
+    return 1;
+}
+
+static Uint16 saturate16(double v) {
+    return v > 65535 ? 65535 : (Uint16)v;
+}
+
+int flightRecord(FlightRecorder* r, const Profiler* p, int sdlEvents, int ticks, int gameEvents, int pipes) {
+    FlightFrame* f = &r->frames[r->count % FLIGHT_FRAMES];
+    double usPerTick = p->msPerTick * 1000.0;
+    Uint64 total = 0;
+    for (int k = 0; k < PHASE_COUNT; k++) {
+        f->phaseUs[k] = saturate16(p->frameTicks[k] * usPerTick);
+        total += p->frameTicks[k];
+    }
+    unsigned long allocs = allocStatsCount();
+    f->frame = p->frame;
+    f->frameUs = (Uint32)(total * usPerTick);
+    f->sdlEvents = saturate16(sdlEvents);
+    f->ticks = ticks > 255 ? 255 : (Uint8)ticks;
+    f->gameEvents = (Uint8)gameEvents;
+    f->pipes = (Uint16)pipes;
+    f->allocs = (Uint32)(allocs - r->lastAllocs);
+    r->lastAllocs = allocs;
+    r->count++;
+
+    if (r->budgetMs <= 0 || f->frameUs <= r->budgetMs * 1000) return 0;
+    if (r->dumps > 0 && r->count - r->lastDump < FLIGHT_COOLDOWN) return 0;
+    if (!dump(r)) return 0;
+    r->lastDump = r->count;
+    r->dumps++;
+    return 1;
+}
@@ -0,0 +1,59 @@
+#ifndef FLIGHTREC_H
+#define FLIGHTREC_H
+
+#include "profiler.h"
+#include <stdatomic.h>
+
+/*
+   Always-on record of the last FLIGHT_FRAMES frames. When a frame runs over
+   the budget, the whole window is written out as hitch_<frame>.fbh (binary)
+   and hitch_<frame>.txt (summary) so rare hitches come with their context.
+   The game thread only copies the window into a snapshot; a writer thread
+   does the file I/O, so a dump doesn't cause a hitch of its own.
+
+   .fbh layout: "FBH1", then uint32 record size, record count, budget in
+   microseconds and phase count, then the FlightFrame records oldest first,
+   all native-endian.
+*/
+
+#define FLIGHT_FRAMES 600
+#define FLIGHT_COOLDOWN 300 // frames between dumps, so one hitch doesn't dump a burst
+#define FLIGHT_DEFAULT_BUDGET_MS 33.3 // one dropped vsync interval at 60 Hz
+
+typedef struct {
+    Uint32 frame;
+    Uint32 frameUs;
+    Uint16 phaseUs[PHASE_COUNT]; // saturates at 65.5 ms
+    Uint16 sdlEvents; // events pumped
+    Uint8 ticks; // simulation ticks run
+    Uint8 gameEvents; // GAME_EVENT_* bits of those ticks
+    Uint16 pipes; // live pipes at the end of the frame
+    Uint32 allocs; // SDL heap allocations during the frame
+} FlightFrame;
+
+typedef struct {
+    FlightFrame frames[FLIGHT_FRAMES];
+    unsigned long count; // frames ever recorded
+    double budgetMs;
+    unsigned long lastDump; // count at the last dump
+    unsigned long lastAllocs;
+    int dumps;
+
+    // The window being written, oldest first; the writer owns it while pending is set
+    FlightFrame snapshot[FLIGHT_FRAMES];
+    unsigned long snapshotCount;
+    atomic_int pending, stop;
+    SDL_sem* wake;
+    SDL_Thread* writer; // NULL: dumps are written on the caller's thread
+} FlightRecorder;
+
+void flightInit(FlightRecorder* r, double budgetMs);
+/* Waits for a dump in progress and stops the writer. */
+void flightShutdown(FlightRecorder* r);
+
+/* Appends the frame the profiler just finished and dumps if it blew the
+   budget. Returns 1 when a dump was started. A hitch while the previous
+   dump is still being written isn't dumped. */
+int flightRecord(FlightRecorder* r, const Profiler* p, int sdlEvents, int ticks, int gameEvents, int pipes);
+
+#endif
@@ -0,0 +1,168 @@
+#include "game.h"
+
+int checkCollision(Rect a, Rect b) {
+    return !(a.x + a.w < b.x ||
+             a.x > b.x + b.w ||
+             a.y + a.h < b.y ||
+             a.y > b.y + b.h);
+}
+
+// SplitMix64 finaliser
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t rngAt(uint64_t seed, uint64_t counter) {
+    return mix64(mix64(seed) + counter * 0x9e3779b97f4a7c15ULL);
+}
+
+// Two draws per spawn slot: the 1-in-5 triple roll and the pipe height
+static int slotRoll(uint64_t seed, unsigned int slot) {
+    return rngAt(seed, 2 * (uint64_t)slot) % 5 == 0;
+}
+
+static int slotHeight(uint64_t seed, unsigned int slot) {
+    return 50 + (int)(rngAt(seed, 2 * (uint64_t)slot + 1) % (WINDOW_HEIGHT - PIPE_GAP - 100));
+}
+
+/*
+   A slot is a triple when its roll succeeds, it is at least slot 3 and none of
+   the previous three slots was a triple (the spawner's cooldown). A slot whose
+   roll failed is never a triple, so three failed rolls in a row reset that
+   history: walk back to the nearest such point (about 2 slots on average) and
+   replay forward from there.
+*/
+CourseSlot courseAt(uint64_t seed, unsigned int slot) {
+    CourseSlot s = {0, slotHeight(seed, slot)};
+    if (slot < 3 || !slotRoll(seed, slot)) return s;
+
+    unsigned int b = slot - 1;
+    while (b > 2 && (slotRoll(seed, b) || slotRoll(seed, b - 1) || slotRoll(seed, b - 2))) b--;
+
+    int sinceTriple = 3;
+    for (unsigned int k = b + 1; k < slot; k++) {
+        if (sinceTriple >= 3 && slotRoll(seed, k)) sinceTriple = 0;
+        else sinceTriple++;
+    }
+    s.triple = sinceTriple >= 3;
+    return s;
+}
+
+void gameReset(GameState* g, uint64_t seed) {
+    g->seed = seed;
+    g->spawnSlot = 0;
+    g->birdY = WINDOW_HEIGHT / 2;
+    g->birdVelocity = 0;
+    g->pipeHead = 0;
+    g->pipeCount = 0;
+    g->pipeTimer = 0;
+    g->score = 0;
+    g->normalPipeCounter = 0;
+    g->threePipeCooldown = 0;
+    g->dashing = 0;
+    g->gameOver = 0;
+    g->frame = 0;
+
+    g->birdRect.x = BIRD_X;
+    g->birdRect.y = (int)g->birdY;
+    g->birdRect.w = BIRD_W;
+    g->birdRect.h = BIRD_H;
+}
+
+static void spawnPipe(GameState* g, int x, int height) {
+    Pipe* p = gamePipe(g, g->pipeHead + g->pipeCount);
+    p->x = x;
+    p->height = height;
+    p->scored = 0;
+    g->pipeCount++;
+}
+
+/* Same decisions as courseAt(), but using the running counters instead of a lookback. */
+int courseSpawn(uint64_t seed, unsigned int slot, int* normalPipeCounter, int* threePipeCooldown, int* height) {
+    *height = slotHeight(seed, slot);
+    if (*threePipeCooldown > 0) { // normal pipe
+        (*threePipeCooldown)--;
+        (*normalPipeCounter)++;
+        return 1;
+    }
+    if (*normalPipeCounter >= 3 && slotRoll(seed, slot)) { // 3-row pipes
+        *normalPipeCounter = 0;
+        *threePipeCooldown = 3;
+        return 3;
+    }
+    (*normalPipeCounter)++; // normal pipe
+    return 1;
+}
+
+void gameStepSpawn(GameState* g) {
+    g->pipeTimer++;
+    if (g->pipeTimer <= PIPE_SPAWN_TICKS) return;
+    g->pipeTimer = 0;
+
+    int height;
+    int n = courseSpawn(g->seed, g->spawnSlot++, &g->normalPipeCounter, &g->threePipeCooldown, &height);
+    for (int j = 0; j < n; j++) spawnPipe(g, WINDOW_WIDTH + j * PIPE_ROW_SPACING, height);
+}
+
+int gameStepBird(GameState* g, GameInput input) {
+    int events = 0;
+    if (input.flap) {
+        g->birdVelocity = FLAP_STRENGTH;
+        events |= GAME_EVENT_FLAP;
+    }
+
+    g->dashing = input.dash;
+    if (input.dash) g->birdVelocity = 0;
+    else g->birdVelocity += GRAVITY;
+
+    g->birdY += g->birdVelocity;
+    g->birdRect.y = (int)g->birdY;
+
+    if (g->birdY <= 0 || g->birdY + g->birdRect.h >= WINDOW_HEIGHT) g->gameOver = 1;
+    return events;
+}
+
+int gameStepPipes(GameState* g) {
+    int events = 0;
+    int currentPipeSpeed = g->dashing ? DASH_SPEED : PIPE_SPEED;
+
+    // Move pipes; only the ones overlapping the bird's fixed x range get tested
+    const int birdLeft = g->birdRect.x, birdRight = g->birdRect.x + g->birdRect.w;
+    for (int k = 0; k < g->pipeCount; k++) {
+        Pipe* p = gamePipe(g, g->pipeHead + k);
+        p->x -= currentPipeSpeed;
+        if (p->x > birdRight || p->x + PIPE_WIDTH < birdLeft) continue;
+
+        Rect topPipe = {p->x, 0, PIPE_WIDTH, p->height};
+        Rect bottomPipe = {p->x, p->height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - p->height - PIPE_GAP};
+        Rect scoreZone = {p->x + PIPE_WIDTH / 2, 0, 1, WINDOW_HEIGHT};
+
+        if (checkCollision(g->birdRect, topPipe) || checkCollision(g->birdRect, bottomPipe)) g->gameOver = 1;
+
+        if (!p->scored && checkCollision(g->birdRect, scoreZone)) {
+            g->score++;
+            p->scored = 1;
+            events |= GAME_EVENT_SCORE;
+        }
+    }
+
+    // Retire pipes that scrolled off the left edge
+    while (g->pipeCount > 0 && gamePipe(g, g->pipeHead)->x + PIPE_WIDTH < 0) {
+        g->pipeHead++;
+        g->pipeCount--;
+    }
+
+    if (g->gameOver) events |= GAME_EVENT_DIED;
+    g->frame++;
+    return events;
+}
+
+/* Advances the simulation by one tick (1 / TICK_RATE s). Returns GAME_EVENT_* bits. */
+int gameStep(GameState* g, GameInput input) {
+    if (g->gameOver) return 0;
+    int events = gameStepBird(g, input);
+    gameStepSpawn(g);
+    return events | gameStepPipes(g);
+}
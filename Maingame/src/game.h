@@ -0,0 +1,116 @@
+#ifndef GAME_H
+#define GAME_H
+
+/*
+   Simulation core shared by the desktop build, the web build (beta.c) and
+   the headless runner. Nothing in here touches SDL, so it can be stepped
+   without a window, renderer or audio device.
+*/
+
+#include <stdint.h>
+
+#define WINDOW_WIDTH 1280
+#define WINDOW_HEIGHT 720
+#define PIPE_WIDTH 100
+#define PIPE_GAP 250
+#define MAX_PIPES 32 // pipe queue capacity, must be a power of two
+#define PIPE_ROW_SPACING (PIPE_WIDTH + 10) // x step between the pipes of a 3-pipe row
+#define PIPE_MAX_HEIGHT (WINDOW_HEIGHT - PIPE_GAP - 50) // tallest top or bottom pipe the spawner makes
+
+#define BIRD_X 250
+#define BIRD_W 106
+#define BIRD_H 60
+
+#define TICK_RATE 60 // gameStep calls per second of game time
+#define PIPE_SPAWN_TICKS 80 // a new pipe (or 3-pipe row) every PIPE_SPAWN_TICKS + 1 ticks
+
+#define GRAVITY 0.25f
+#define FLAP_STRENGTH -8.0f
+#define PIPE_SPEED 3
+#define DASH_SPEED 12
+
+/* Bits returned by gameStep so the caller can play sounds etc. */
+#define GAME_EVENT_FLAP  0x1
+#define GAME_EVENT_SCORE 0x2
+#define GAME_EVENT_DIED  0x4
+
+typedef struct {
+    int x, y, w, h;
+} Rect;
+
+typedef struct {
+    int x, height;
+    int scored;
+} Pipe;
+
+/*
+   Live pipes form a FIFO ring ordered by x: they are always spawned at the
+   right edge and retire off the left. A pipe lives for at most
+   (WINDOW_WIDTH + 3-row span + PIPE_WIDTH) / PIPE_SPEED ticks, so the ring
+   can never hold more than the bound below and spawning never drops a pipe.
+*/
+#define PIPE_MAX_LIVE \
+    (3 * ((WINDOW_WIDTH + 2 * PIPE_ROW_SPACING + PIPE_WIDTH) / (PIPE_SPEED * (PIPE_SPAWN_TICKS + 1)) + 1))
+_Static_assert(PIPE_MAX_LIVE <= MAX_PIPES, "pipe queue too small for the spawn rate");
+_Static_assert((MAX_PIPES & (MAX_PIPES - 1)) == 0, "MAX_PIPES must be a power of two");
+
+/* What the spawner produces at spawn slot n of a course. */
+typedef struct {
+    int triple; // 3-pipe row instead of a single pipe
+    int height; // top pipe height
+} CourseSlot;
+
+typedef struct {
+    uint64_t seed; // the whole pipe course is a pure function of this
+    unsigned int spawnSlot; // spawns so far
+    float birdY;
+    float birdVelocity;
+    Rect birdRect;
+    Pipe pipes[MAX_PIPES];
+    unsigned int pipeHead; // running index of the oldest live pipe
+    int pipeCount;
+    int pipeTimer;
+    int score;
+    int normalPipeCounter;
+    int threePipeCooldown;
+    int dashing;
+    int gameOver;
+    unsigned long frame;
+} GameState;
+
+typedef struct {
+    int flap; /* SPACE pressed since the last step */
+    int dash; /* SHIFT held */
+} GameInput;
+
+/* Pipe number n (a running index, pipeHead <= n < pipeHead + pipeCount). */
+static inline Pipe* gamePipe(GameState* g, unsigned int n) {
+    return &g->pipes[n & (MAX_PIPES - 1)];
+}
+
+static inline const Pipe* gamePipeConst(const GameState* g, unsigned int n) {
+    return &g->pipes[n & (MAX_PIPES - 1)];
+}
+
+/* Counter-based generator: the value for (seed, counter) needs no prior draws. */
+uint64_t rngAt(uint64_t seed, uint64_t counter);
+
+/* Spawn slot n of the course for seed, in expected O(1) without stepping the game. */
+CourseSlot courseAt(uint64_t seed, unsigned int slot);
+
+/* Spawner decision for slot n given the running pattern counters, which it
+   updates. Returns how many pipes to place (1, or 3 for a row), all *height tall. */
+int courseSpawn(uint64_t seed, unsigned int slot, int* normalPipeCounter, int* threePipeCooldown, int* height);
+
+int checkCollision(Rect a, Rect b);
+void gameReset(GameState* g, uint64_t seed);
+int gameStep(GameState* g, GameInput input);
+
+/* gameStep's phases, in order, for callers that time them separately: bird
+   physics and bounds, the spawner, then pipe movement, collision and
+   scoring (which also ends the tick). Only valid while !g->gameOver. */
+int gameStepBird(GameState* g, GameInput input);
+void gameStepSpawn(GameState* g);
+int gameStepPipes(GameState* g);
+
+#endif
@@ -0,0 +1,219 @@
+#include "headless.h"
+#include "replay.h"
+#include "batch.h"
+#include "vecenv.h"
+#include "perfctr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+GameInput botInput(const GameState* g) {
+    GameInput in = {0, 0};
+    float gapBottom = WINDOW_HEIGHT / 2 + PIPE_GAP / 2;
+
+    // Aim for the gap of the first pipe the bird hasn't cleared yet
+    for (int k = 0; k < g->pipeCount; k++) {
+        const Pipe* p = gamePipeConst(g, g->pipeHead + k);
+        if (p->x + PIPE_WIDTH >= BIRD_X) {
+            gapBottom = p->height + PIPE_GAP;
+            break;
+        }
+    }
+
+    // Flap just before the bird would sink below the bottom of the gap
+    if (g->birdY + BIRD_H + g->birdVelocity > gapBottom - 15 && g->birdVelocity >= 0) in.flap = 1;
+    return in;
+}
+
+/* botInput for every bird of a VecEnv at once, straight off the SoA lanes. */
+static void vecBotActions(const VecEnv* e, uint8_t* actions) {
+    for (int i = 0; i < e->count; i++) {
+        // nearX[0] is the first pipe not yet cleared, as botInput looks for
+        float gapBottom = e->nearH[0][i] ? e->nearH[0][i] + PIPE_GAP : WINDOW_HEIGHT / 2 + PIPE_GAP / 2;
+        actions[i] = e->birdY[i] + BIRD_H + e->birdVelocity[i] > gapBottom - 15 && e->birdVelocity[i] >= 0 ? VEC_ACTION_FLAP : 0;
+    }
+}
+
+/* Steps a VecEnv of `birds` lanes until `steps` bird-steps have run. */
+static int runVec(int birds, unsigned long long steps, uint64_t seed) {
+    VecEnv env;
+    uint8_t* actions = malloc(birds);
+    if (!actions || vecEnvInit(&env, birds, seed) != 0) { free(actions); printf("headless: out of memory\n"); return 1; }
+
+    unsigned long long totalScore = 0;
+    int bestScore = 0;
+    clock_t start = clock();
+    while (env.steps < steps) {
+        vecBotActions(&env, actions);
+        vecEnvStep(&env, actions);
+        for (int i = 0; i < birds; i++) {
+            if (!env.done[i]) continue;
+            totalScore += env.lastScore[i];
+            if (env.lastScore[i] > bestScore) bestScore = env.lastScore[i];
+        }
+    }
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (seconds <= 0) seconds = 1e-9;
+    printf("vec: %d birds (%s), %llu bird-steps in %.3f s = %.2f M steps/s\n",
+        birds, vecEnvKernel(), env.steps, seconds, env.steps / seconds / 1e6);
+    printf("vec: seed %llu, %llu episodes, best score %d, mean score %.2f\n", (unsigned long long)seed, env.episodes,
+        bestScore, env.episodes ? (double)totalScore / env.episodes : 0.0);
+    vecEnvFree(&env);
+    free(actions);
+    return 0;
+}
+
+/* The plain bot run, with hardware counters read around each gameStep phase. */
+static int runPerf(unsigned long frames, uint64_t seed) {
+    enum { STEP_BOT, STEP_BIRD, STEP_SPAWN, STEP_PIPES, STEP_PHASES };
+    static const char* const names[STEP_PHASES] = {"bot", "bird", "spawn", "pipes"};
+    PerfCounters perf;
+    if (perfOpen(&perf, STEP_PHASES, names) != 0) return 1;
+
+    GameState game;
+    gameReset(&game, seed);
+    unsigned long games = 1;
+    for (unsigned long f = 0; f < frames; f++) {
+        perfFrameBegin(&perf);
+        GameInput in = botInput(&game);
+        perfMark(&perf, STEP_BOT);
+        int events = gameStepBird(&game, in);
+        perfMark(&perf, STEP_BIRD);
+        gameStepSpawn(&game);
+        perfMark(&perf, STEP_SPAWN);
+        events |= gameStepPipes(&game);
+        perfMark(&perf, STEP_PIPES);
+        if (events & GAME_EVENT_DIED) gameReset(&game, seed + games++);
+    }
+
+    printf("headless: seed %llu, %lu games\n", (unsigned long long)seed, games);
+    perfPrint(&perf, stdout);
+    perfClose(&perf);
+    return 0;
+}
+
+/* Plays a recorded session back through gameStep and checks every game ends
+   at the recorded tick with the recorded score. */
+static int verifyReplay(const char* path) {
+    Replay r;
+    if (replayLoad(&r, path) != 0) { printf("headless: can't read replay %s\n", path); return 1; }
+
+    int failures = 0;
+    unsigned int n;
+    for (n = 0;; n++) {
+        GameState game;
+        GameInput in;
+        gameReset(&game, r.seed + n);
+
+        int result;
+        while ((result = replayInput(&r, &game, &in)) == REPLAY_STEP) {
+            if (game.gameOver) break; // died earlier than the recording says
+            gameStep(&game, in);
+        }
+        if (result == REPLAY_FINISHED) break;
+        if (result == REPLAY_STEP) replaySkipGame(&r);
+
+        int ok = result == REPLAY_GAME_OVER && game.score == r.endScore;
+        if (!ok) failures++;
+        printf("game %u: %lu ticks, score %d (recorded %d)%s%s\n", n, game.frame, game.score, r.endScore,
+            game.gameOver ? "" : ", abandoned", ok ? "" : "  DESYNC");
+    }
+
+    printf("headless: replay %s, seed %llu, %u games, %d desynced\n", path, (unsigned long long)r.seed, n, failures);
+    replayFree(&r);
+    return failures ? 1 : 0;
+}
+
+/* Checks courseAt against the spawner's running counters, slot by slot, for
+   eight seeds from seed. */
+static int checkCourse(unsigned long slots, uint64_t seed) {
+    unsigned long mismatches = 0;
+    for (uint64_t s = seed; s < seed + 8; s++) {
+        int normalPipeCounter = 0, threePipeCooldown = 0;
+        for (unsigned long n = 0; n < slots; n++) {
+            int height;
+            int triple = courseSpawn(s, (unsigned int)n, &normalPipeCounter, &threePipeCooldown, &height) == 3;
+            CourseSlot c = courseAt(s, (unsigned int)n);
+            if (c.triple == triple && c.height == height) continue;
+            if (mismatches++ < 10)
+                printf("seed %llu slot %lu: courseAt %d/%d, spawner %d/%d\n", (unsigned long long)s, n, c.triple, c.height, triple, height);
+        }
+    }
+    printf("headless: course check, seeds %llu..%llu, %lu slots each, %lu mismatches\n", (unsigned long long)seed,
+        (unsigned long long)(seed + 7), slots, mismatches);
+    return mismatches ? 1 : 0;
+}
+
+int runHeadless(int argc, char* argv[]) {
+    unsigned long frames = 10000000;
+    uint64_t seed = (uint64_t)time(NULL);
+    const char* recordPath = NULL;
+    BatchOptions batch = {0, 0, 0, 100000, botInput};
+    int vecBirds = 0, perf = 0;
+    unsigned long courseSlots = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (strcmp(argv[i], "--play") == 0 && i + 1 < argc) return verifyReplay(argv[++i]);
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) batch.games = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) batch.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) batch.maxTicks = strtoul(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "--vec") == 0 && i + 1 < argc) vecBirds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--perf") == 0) perf = 1;
+        else if (strcmp(argv[i], "--check-course") == 0 && i + 1 < argc) courseSlots = strtoul(argv[++i], NULL, 10);
+    }
+
+    if (courseSlots > 0) return checkCourse(courseSlots, seed);
+    if (vecBirds > 0) return runVec(vecBirds, frames, seed);
+    if (perf) return runPerf(frames, seed);
+
+    if (batch.games > 0) {
+        BatchResult result;
+        batch.seed = seed;
+        int threads = batchRun(&batch, &result);
+        if (threads < 0) { printf("headless: out of memory\n"); return 1; }
+        printf("batch: seed %llu on %d threads\n", (unsigned long long)seed, threads);
+        batchPrint(&result);
+        return 0;
+    }
+
+    Replay replay;
+    replayBegin(&replay, seed);
+    // Game i plays the course for seed + i
+    GameState game;
+    gameReset(&game, seed);
+
+    unsigned long games = 1, totalScore = 0;
+    int bestScore = 0;
+    clock_t start = clock();
+
+    for (unsigned long f = 0; f < frames; f++) {
+        GameInput in = botInput(&game);
+        if (recordPath) replayRecordInput(&replay, &game, in);
+        if (gameStep(&game, in) & GAME_EVENT_DIED) {
+            if (recordPath) replayEndGame(&replay, &game);
+            totalScore += game.score;
+            if (game.score > bestScore) bestScore = game.score;
+            gameReset(&game, seed + games);
+            games++;
+        }
+    }
+
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    if (seconds <= 0) seconds = 1e-9;
+    printf("headless: %lu frames in %.3f s (%.2f M frames/s)\n", frames, seconds, frames / seconds / 1e6);
+    printf("headless: seed %llu, %lu games, best score %d, mean score %.2f\n",
+        (unsigned long long)seed, games, bestScore, games > 1 ? (double)totalScore / (games - 1) : 0.0);
+
+    if (recordPath) {
+        replayEndGame(&replay, &game);
+        if (replaySave(&replay, recordPath) != 0) printf("headless: failed to write %s\n", recordPath);
+        else printf("headless: recorded %lu bytes to %s\n", (unsigned long)replay.size, recordPath);
+    }
+    replayFree(&replay);
+    return 0;
+}
@@ -0,0 +1,19 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "game.h"
+
+/* Picks the input for the next step; used by the headless runner. */
+GameInput botInput(const GameState* g);
+
+/* Runs the simulation without SDL as fast as possible and prints a summary.
+   Understands --frames N, --seed S and --record FILE; --play FILE instead
+   checks a recorded session plays back identically, and --batch N plays N
+   games across --threads T workers, and --vec K steps K birds in lockstep
+   through the SIMD VecEnv for --frames bird-steps. --perf reports hardware
+   counters per gameStep phase (Linux). --check-course N checks courseAt
+   against the spawner over N slots of eight seeds. Returns a process exit
+   code. */
+int runHeadless(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,12 @@
+// Standalone headless build: the SDL-free modules only.
+#include "headless.h"
+#include "sampler.h"
+#include <stddef.h>
+
+int main(int argc, char* argv[]) {
+    const char* profilePath = samplerPathArg(argc, argv);
+    if (profilePath && samplerStart(0) != 0) profilePath = NULL;
+    int result = runHeadless(argc, argv);
+    if (profilePath) samplerStop(profilePath);
+    return result;
+}
@@ -0,0 +1,265 @@
+#include "log.h"
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define LIMIT_SLOTS 64 // distinct messages the rate limiter tracks; beyond that, lines pass
+
+typedef struct {
+    atomic_ulong sequence; // Vyukov bounded queue: pos = free for the producer at pos, pos + 1 = filled
+    Uint64 ticks;
+    int level;
+    const char* msg;
+    int fieldCount;
+    LogField fields[LOG_MAX_FIELDS]; // LOG_FIELD_STR values hold an offset into text
+    char text[LOG_TEXT];
+} LogRecord;
+
+typedef struct {
+    const char* msg;
+    Uint64 windowStart;
+    int count;
+    unsigned long suppressed;
+} RateLimit;
+
+static LogRecord ring[LOG_RING];
+static atomic_ulong tail; // next position producers claim
+static unsigned long head; // writer only
+static atomic_ulong dropped;
+static unsigned long droppedReported;
+static atomic_int running, stop, minLevel = LOG_INFO;
+static SDL_Thread* writer;
+static FILE* file;
+static Uint64 origin;
+static RateLimit limits[LIMIT_SLOTS];
+
+static const char* levelNames[LOG_LEVELS] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+int logLevelByName(const char* name) {
+    static const char* names[LOG_LEVELS] = {"debug", "info", "warn", "error"};
+    for (int i = 0; i < LOG_LEVELS; i++)
+        if (strcmp(name, names[i]) == 0) return i;
+    return -1;
+}
+
+static void fillRecord(LogRecord* r, int level, const char* msg, va_list args) {
+    r->ticks = SDL_GetPerformanceCounter();
+    r->level = level;
+    r->msg = msg;
+    r->fieldCount = 0;
+    size_t used = 0;
+    for (;;) {
+        LogField f = va_arg(args, LogField);
+        if (f.type == LOG_FIELD_END || r->fieldCount == LOG_MAX_FIELDS) break;
+        if (f.type == LOG_FIELD_STR) {
+            // Copy the string in, truncated to what's left of text (the last byte stays a terminator)
+            size_t len = strlen(f.v.s);
+            if (len > LOG_TEXT - 1 - used) len = LOG_TEXT - 1 - used;
+            memcpy(r->text + used, f.v.s, len);
+            r->text[used + len] = '\0';
+            f.v.i = (long long)used;
+            used += len + 1;
+            if (used > LOG_TEXT - 1) used = LOG_TEXT - 1;
+        }
+        r->fields[r->fieldCount++] = f;
+    }
+}
+
+static int needsQuotes(const char* s) {
+    if (!*s) return 1;
+    for (; *s; s++)
+        if (*s == ' ' || *s == '=' || *s == '"' || *s == '\n') return 1;
+    return 0;
+}
+
+/* snprintf at len; a line that runs out of room stops at size - 1. */
+static int append(char* line, int size, int len, const char* fmt, ...) {
+    if (len >= size - 1) return len;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(line + len, size - len, fmt, args);
+    va_end(args);
+    return n < 0 ? len : (len + n < size ? len + n : size - 1);
+}
+
+/* One logfmt line: seconds since start, level, message, key=value fields. */
+static int formatRecord(const LogRecord* r, char* line, int size) {
+    double seconds = origin ? (double)(r->ticks - origin) / SDL_GetPerformanceFrequency() : 0.0;
+    int len = append(line, size, 0, "%10.3f %-5s %s", seconds, levelNames[r->level], r->msg);
+    for (int i = 0; i < r->fieldCount && len < size - 1; i++) {
+        const LogField* f = &r->fields[i];
+        if (f->type == LOG_FIELD_INT) len = append(line, size, len, " %s=%lld", f->key, f->v.i);
+        else if (f->type == LOG_FIELD_NUM) len = append(line, size, len, " %s=%g", f->key, f->v.f);
+        else {
+            const char* s = r->text + f->v.i;
+            if (!needsQuotes(s)) { len = append(line, size, len, " %s=%s", f->key, s); continue; }
+            len = append(line, size, len, " %s=\"", f->key);
+            for (; *s && len < size - 3; s++) { // leaves room for the closing quote and NUL
+                if (*s == '"' || *s == '\\') line[len++] = '\\';
+                line[len++] = *s == '\n' ? ' ' : *s;
+            }
+            if (len < size - 1) line[len++] = '"';
+            line[len] = '\0';
+        }
+    }
+    if (len > size - 2) len = size - 2;
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+static void writeLine(const char* line) {
+    fputs(line, stdout);
+    if (file) fputs(line, file);
+}
+
+/* The logger's own warnings: about a message (may be NULL) and a count. */
+static void writeNote(const char* note, const char* message, unsigned long count, Uint64 ticks) {
+    LogRecord r;
+    memset(&r, 0, sizeof(r));
+    r.ticks = ticks;
+    r.level = LOG_WARN;
+    r.msg = note;
+    if (message) {
+        LogField f = {"message", LOG_FIELD_STR, {.i = 0}}; // offset 0 of text
+        snprintf(r.text, sizeof(r.text), "%s", message);
+        r.fields[r.fieldCount++] = f;
+    }
+    r.fields[r.fieldCount++] = logInt("count", (long long)count);
+    char line[512];
+    formatRecord(&r, line, sizeof(line));
+    writeLine(line);
+}
+
+/* LOG_BURST lines per message per second; the rest are counted and reported
+   when that message next shows up in a new window, or at shutdown. */
+static int rateAllow(const LogRecord* r) {
+    Uint64 second = SDL_GetPerformanceFrequency();
+    unsigned int h = (unsigned int)(((uintptr_t)r->msg >> 3) * 2654435761u);
+    for (int probe = 0; probe < LIMIT_SLOTS; probe++) {
+        RateLimit* l = &limits[(h + probe) & (LIMIT_SLOTS - 1)];
+        if (l->msg && l->msg != r->msg) continue;
+        if (!l->msg) { l->msg = r->msg; l->windowStart = r->ticks; }
+        if (r->ticks - l->windowStart >= second) {
+            if (l->suppressed) writeNote("log lines suppressed", l->msg, l->suppressed, r->ticks);
+            l->windowStart = r->ticks;
+            l->count = 0;
+            l->suppressed = 0;
+        }
+        if (++l->count <= LOG_BURST) return 1;
+        l->suppressed++;
+        return 0;
+    }
+    return 1;
+}
+
+/* Writer thread: everything published so far, oldest first. */
+static void drain(void) {
+    char line[512];
+    int wrote = 0;
+    for (;;) {
+        LogRecord* r = &ring[head & (LOG_RING - 1)];
+        if (atomic_load_explicit(&r->sequence, memory_order_acquire) != head + 1) break;
+        if (rateAllow(r)) {
+            formatRecord(r, line, sizeof(line));
+            writeLine(line);
+            wrote = 1;
+        }
+        atomic_store_explicit(&r->sequence, head + LOG_RING, memory_order_release);
+        head++;
+    }
+    unsigned long lost = atomic_load_explicit(&dropped, memory_order_relaxed);
+    if (lost != droppedReported) {
+        writeNote("log ring full, records dropped", NULL, lost - droppedReported, SDL_GetPerformanceCounter());
+        droppedReported = lost;
+        wrote = 1;
+    }
+    if (wrote) {
+        fflush(stdout);
+        if (file) fflush(file);
+    }
+}
+
+static int writerMain(void* arg) {
+    (void)arg;
+    while (!atomic_load(&stop)) {
+        drain();
+        SDL_Delay(LOG_FLUSH_MS);
+    }
+    drain();
+    return 0;
+}
+
+void logEmit(int level, const char* msg, ...) {
+    if (level < atomic_load_explicit(&minLevel, memory_order_relaxed)) return;
+    va_list args;
+    va_start(args, msg);
+
+    if (!atomic_load_explicit(&running, memory_order_acquire)) {
+        LogRecord r;
+        char line[512];
+        fillRecord(&r, level, msg, args);
+        va_end(args);
+        formatRecord(&r, line, sizeof(line));
+        writeLine(line);
+        return;
+    }
+
+    // Claim a slot; a full ring drops the record rather than wait
+    unsigned long pos = atomic_load_explicit(&tail, memory_order_relaxed);
+    LogRecord* r;
+    for (;;) {
+        r = &ring[pos & (LOG_RING - 1)];
+        long diff = (long)(atomic_load_explicit(&r->sequence, memory_order_acquire) - pos);
+        if (diff == 0 && atomic_compare_exchange_weak_explicit(&tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) break;
+        if (diff < 0) {
+            atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+            va_end(args);
+            return;
+        }
+        if (diff > 0) pos = atomic_load_explicit(&tail, memory_order_relaxed);
+    }
+    fillRecord(r, level, msg, args);
+    va_end(args);
+    atomic_store_explicit(&r->sequence, pos + 1, memory_order_release);
+}
+
+int logInit(const char* path, int minimum) {
+    atomic_store(&minLevel, minimum);
+    origin = SDL_GetPerformanceCounter();
+    for (unsigned long i = 0; i < LOG_RING; i++) atomic_init(&ring[i].sequence, i);
+    atomic_init(&tail, 0);
+    head = 0;
+    if (path) {
+        file = fopen(path, "w");
+        if (!file) logWarn("can't open log file", logStr("path", path));
+    }
+    atomic_store(&stop, 0);
+    atomic_store(&running, 1);
+    writer = SDL_CreateThread(writerMain, "log writer", NULL);
+    if (!writer) {
+        atomic_store(&running, 0);
+        logWarn("can't start log writer, logging synchronously", logStr("error", SDL_GetError()));
+        return -1;
+    }
+    return 0;
+}
+
+void logShutdown(void) {
+    if (writer) {
+        atomic_store(&running, 0);
+        atomic_store(&stop, 1);
+        SDL_WaitThread(writer, NULL);
+        writer = NULL;
+    }
+    Uint64 now = SDL_GetPerformanceCounter();
+    for (int i = 0; i < LIMIT_SLOTS; i++)
+        if (limits[i].suppressed) writeNote("log lines suppressed", limits[i].msg, limits[i].suppressed, now);
+    memset(limits, 0, sizeof(limits));
+    if (file) {
+        fclose(file);
+        file = NULL;
+    }
+    fflush(stdout);
+}
@@ -0,0 +1,92 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+
+/*
+   Structured logging off the game thread. A record is a level, a message
+   and typed key/value fields:
+
+       logWarn("icon load failed", logStr("path", path), logStr("error", IMG_GetError()));
+
+   Any thread pushes records into a bounded lock-free MPSC ring (strings
+   are copied in, nothing is formatted); the writer thread formats them as
+   logfmt lines to stdout and the --log file. Pushing never blocks: when the
+   ring is full the record is dropped and counted. The writer also rate
+   limits each message to LOG_BURST lines a second and reports what it held
+   back. Before logInit and after logShutdown records are written
+   synchronously instead, so tools that never start the writer still log.
+
+   Messages and keys must be string literals; they are kept by pointer.
+*/
+
+enum {
+    LOG_DEBUG,
+    LOG_INFO,
+    LOG_WARN,
+    LOG_ERROR,
+    LOG_LEVELS
+};
+
+#define LOG_RING 1024 // records, a power of two
+#define LOG_MAX_FIELDS 6
+#define LOG_TEXT 128 // bytes of string field values per record
+#define LOG_BURST 10 // lines per message per second before rate limiting kicks in
+#define LOG_FLUSH_MS 20
+
+enum {
+    LOG_FIELD_END,
+    LOG_FIELD_INT,
+    LOG_FIELD_NUM,
+    LOG_FIELD_STR
+};
+
+typedef struct {
+    const char* key;
+    int type;
+    union {
+        long long i;
+        double f;
+        const char* s;
+    } v;
+} LogField;
+
+static inline LogField logInt(const char* key, long long v) {
+    LogField f = {key, LOG_FIELD_INT, {.i = v}};
+    return f;
+}
+
+static inline LogField logNum(const char* key, double v) {
+    LogField f = {key, LOG_FIELD_NUM, {.f = v}};
+    return f;
+}
+
+static inline LogField logStr(const char* key, const char* v) {
+    LogField f = {key, LOG_FIELD_STR, {.s = v ? v : ""}};
+    return f;
+}
+
+static inline LogField logEnd(void) {
+    LogField f = {NULL, LOG_FIELD_END, {.i = 0}};
+    return f;
+}
+
+/* Fields are passed by value and end at a LOG_FIELD_END; use the macros. */
+void logEmit(int level, const char* msg, ...);
+
+#define logDebug(msg, ...) logEmit(LOG_DEBUG, msg, ##__VA_ARGS__, logEnd())
+#define logInfo(msg, ...) logEmit(LOG_INFO, msg, ##__VA_ARGS__, logEnd())
+#define logWarn(msg, ...) logEmit(LOG_WARN, msg, ##__VA_ARGS__, logEnd())
+#define logError(msg, ...) logEmit(LOG_ERROR, msg, ##__VA_ARGS__, logEnd())
+
+/* Starts the writer thread. path (may be NULL) gets a copy of every line.
+   Records below minLevel are discarded at the call. Returns 0 on success;
+   on failure logging stays synchronous. */
+int logInit(const char* path, int minLevel);
+/* Drains the ring, stops the writer and closes the file. */
+void logShutdown(void);
+/* "debug", "info", "warn" or "error"; -1 when unknown. */
+int logLevelByName(const char* name);
+
+#endif
@@ -4,77 +4,230 @@
 #include <SDL2/SDL_ttf.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
-
-#define WINDOW_WIDTH 1280
-#define WINDOW_HEIGHT 720
-#define PIPE_WIDTH 100
-#define PIPE_GAP 250
-#define MAX_PIPES 20
-
-typedef struct {
-    int x, height;
-    int active;
-    int scored;
-} Pipe;
-
-int checkCollision(SDL_Rect a, SDL_Rect b) {
-    return !(a.x + a.w < b.x ||
-             a.x > b.x + b.w ||
-             a.y + a.h < b.y ||
-             a.y > b.y + b.h);
+#include "game.h"
+#include "headless.h"
+#include "textcache.h"
+#include "atlas.h"
+#include "replay.h"
+#include "profiler.h"
+#include "flightrec.h"
+#include "allocstats.h"
+#include "sampler.h"
+#include "arena.h"
+#include "startup.h"
+#include "scene.h"
+#include "backend.h"
+#include "memreport.h"
+#include "metrics.h"
+#include "log.h"
+
+#define MAX_FRAME_TIME 0.25 // seconds of simulation we are willing to catch up in one frame
+#define IDLE_WAIT_MS 250 // longest a static screen sleeps between loop passes; memory and metrics sampling still tick
+
+#define OVERLAY_LINES (PHASE_COUNT + 3) // header, phases, frame, heap
+
+/* F3 overlay: per-phase average and p99 over the last PROF_WINDOW frames. */
+static void drawProfilerOverlay(SDL_Renderer* renderer, TextCache* cache, TTF_Font* font, char lines[][TEXT_CACHE_MAX_LEN]) {
+    const SDL_Color grey = {220, 220, 220, 255};
+    SDL_Rect panel = {10, 10, 300, 12 + 22 * OVERLAY_LINES};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+
+    for (int i = 0; i < OVERLAY_LINES; i++) {
+        int w, h;
+        SDL_Texture* tex = textCacheGet(cache, font, lines[i], grey, &w, &h);
+        if (!tex) continue;
+        SDL_Rect dst = {20, 16 + 22 * i, w, h};
+        SDL_RenderCopy(renderer, tex, NULL, &dst);
+    }
 }
 
-void resetGame(float* birdY, float* birdVelocity, Pipe pipes[], int* pipeTimer, int* score, int* normalPipeCounter, int* threePipeCooldown) {
-    *birdY = WINDOW_HEIGHT / 2;
-    *birdVelocity = 0;
-    for (int i = 0; i < MAX_PIPES; i++) pipes[i].active = 0;
-    *pipeTimer = 0;
-    *score = 0;
-    *normalPipeCounter = 0;
-    *threePipeCooldown = 0;
+/* Runs a throwaway frame heavier than any real one, so SDL's render command
+   pool, vertex buffer and event queue are already full size when play starts. */
+static void warmSdlPools(SDL_Renderer* renderer, const Atlas* atlas, FrameArena* arena) {
+    SpriteBatch batch;
+    SDL_Rect r = {0, 0, 1, 1};
+    batchBegin(&batch, arena, BATCH_MAX_QUADS);
+    for (int i = 0; i < BATCH_MAX_QUADS; i++) batchSprite(&batch, atlas, SPRITE_BG, &r, 0);
+    batchFlush(&batch, renderer, atlas);
+    for (int i = 0; i < 32; i++) SDL_RenderCopy(renderer, atlas->texture, NULL, &r);
+    SDL_RenderFlush(renderer);
+
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = SDL_USEREVENT;
+    for (int i = 0; i < 128; i++) SDL_PushEvent(&e);
+    SDL_FlushEvent(SDL_USEREVENT);
+    arenaReset(arena);
 }
 
 int main(int argc, char* argv[]) {
-    srand((unsigned int)time(NULL));
+    static StartupTimeline startup;
+    startupBegin(&startup);
+    // --profile samples the whole run, headless or not, and writes folded stacks at exit
+    const char* profilePath = samplerPathArg(argc, argv);
+    if (profilePath && samplerStart(0) != 0) profilePath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            int result = runHeadless(argc, argv);
+            if (profilePath) samplerStop(profilePath);
+            return result;
+        }
+    }
+
+    // Game n of the session plays the course for sessionSeed + n
+    uint64_t sessionSeed = (uint64_t)time(NULL);
+    unsigned int gamesStarted = 0;
+    const char* recordPath = NULL;
+    const char* playPath = NULL;
+    const char* tracePath = NULL;
+    const char* metricsAddress = NULL;
+    const char* logPath = NULL;
+    int logLevel = LOG_INFO;
+    double hitchBudgetMs = FLIGHT_DEFAULT_BUDGET_MS;
+    int perfCounters = 0, startupReport = 0, exitAfterFirstFrame = 0, memReport = 0;
+    int rotation = -1; // --rotation cached|native; by default cached on the software renderer only
+    int backendKind = BACKEND_SDL, autoDriver = 0; // --renderer sdl|cpu|null|auto
+    int cpuSimd = BLIT_AUTO; // --cpu-simd scalar|sse2|avx2
+    int cpuThreads = 0; // --cpu-threads N, 0 for one per core
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--perf") == 0) perfCounters = 1;
+        else if (strcmp(argv[i], "--startup-report") == 0) startupReport = 1;
+        else if (strcmp(argv[i], "--exit-after-first-frame") == 0) exitAfterFirstFrame = 1;
+        else if (strcmp(argv[i], "--mem-report") == 0) memReport = 1;
+    }
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--startup-bench") == 0) return startupBench(argv[0], atoi(argv[i + 1]));
+        if (strcmp(argv[i], "--seed") == 0) sessionSeed = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "--record") == 0) recordPath = argv[i + 1];
+        else if (strcmp(argv[i], "--play") == 0) playPath = argv[i + 1];
+        else if (strcmp(argv[i], "--trace") == 0) tracePath = argv[i + 1];
+        else if (strcmp(argv[i], "--metrics") == 0) metricsAddress = argv[i + 1];
+        else if (strcmp(argv[i], "--log") == 0) logPath = argv[i + 1];
+        else if (strcmp(argv[i], "--log-level") == 0 && logLevelByName(argv[i + 1]) >= 0) logLevel = logLevelByName(argv[i + 1]);
+        else if (strcmp(argv[i], "--renderer") == 0 && strcmp(argv[i + 1], "auto") == 0) autoDriver = 1;
+        else if (strcmp(argv[i], "--renderer") == 0 && backendByName(argv[i + 1]) >= 0) backendKind = backendByName(argv[i + 1]);
+        else if (strcmp(argv[i], "--cpu-threads") == 0) cpuThreads = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--cpu-simd") == 0 && blitLevelByName(argv[i + 1]) >= 0) cpuSimd = blitLevelByName(argv[i + 1]);
+        else if (strcmp(argv[i], "--rotation") == 0) rotation = strcmp(argv[i + 1], "cached") == 0;
+        else if (strcmp(argv[i], "--hitch-budget") == 0) hitchBudgetMs = atof(argv[i + 1]); // 0 turns dumps off
+    }
 
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) { printf("SDL_Init failed: %s\n", SDL_GetError()); return 1; }
-    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) { printf("IMG_Init failed: %s\n", IMG_GetError()); SDL_Quit(); return 1; }
-    if (TTF_Init() == -1) { printf("TTF_Init failed: %s\n", TTF_GetError()); SDL_Quit(); return 1; }
+    // Diagnostics go through the log writer thread from here on; atexit covers the early returns
+    logInit(logPath, logLevel);
+    atexit(logShutdown);
+
+    // --play feeds a recorded session into the step loop instead of the keyboard
+    Replay replay;
+    if (playPath) {
+        if (replayLoad(&replay, playPath) != 0) { logError("can't load replay", logStr("path", playPath)); return 1; }
+        sessionSeed = replay.seed;
+        recordPath = NULL;
+    } else {
+        replayBegin(&replay, sessionSeed);
+        if (recordPath) replayReserve(&replay, 64 * 1024); // hours of play
+    }
+
+    startupMark(&startup, "args and replay");
+
+    if (allocStatsInstall() != 0) logWarn("can't hook SDL allocator", logStr("error", SDL_GetError()));
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) { logError("SDL_Init failed", logStr("error", SDL_GetError())); return 1; }
+    startupMark(&startup, "SDL_Init");
+    if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) { logError("IMG_Init failed", logStr("error", IMG_GetError())); SDL_Quit(); return 1; }
+    startupMark(&startup, "IMG_Init");
+    if (TTF_Init() == -1) { logError("TTF_Init failed", logStr("error", TTF_GetError())); SDL_Quit(); return 1; }
+    startupMark(&startup, "TTF_Init");
 
     SDL_Window* window = SDL_CreateWindow("Froppy Bird",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
-    if (!window) { printf("SDL_CreateWindow failed: %s\n", SDL_GetError()); SDL_Quit(); return 1; }
-
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-    if (!renderer) { printf("SDL_CreateRenderer failed: %s\n", SDL_GetError()); SDL_DestroyWindow(window); SDL_Quit(); return 1; }
+    if (!window) { logError("SDL_CreateWindow failed", logStr("error", SDL_GetError())); SDL_Quit(); return 1; }
+    startupMark(&startup, "create window");
+
+    // The CPU renderer only needs something to present a texture with, software will do; the null one needs nothing.
+    // --renderer auto times each SDL driver briefly and keeps the fastest, accelerated or not.
+    SDL_Renderer* renderer = NULL;
+    if (backendKind != BACKEND_NULL) {
+        int driver = -1;
+        Uint32 flags = backendKind == BACKEND_CPU ? 0 : SDL_RENDERER_ACCELERATED;
+        if (autoDriver && backendKind == BACKEND_SDL && (driver = backendPickDriver(window, BACKEND_AUTO_MS)) >= 0) flags = 0;
+        if (autoDriver) startupMark(&startup, "pick render driver");
+        renderer = SDL_CreateRenderer(window, driver, flags | SDL_RENDERER_PRESENTVSYNC);
+        if (!renderer) { logError("SDL_CreateRenderer failed", logStr("error", SDL_GetError())); SDL_DestroyWindow(window); SDL_Quit(); return 1; }
+        startupMark(&startup, "create renderer");
+    }
 
     SDL_Surface* icon = IMG_Load("assets/sprites/icon.png");
     if (icon) {
         SDL_SetWindowIcon(window, icon);
         SDL_FreeSurface(icon);
     } else {
-        printf("Failed to load icon: %s\n", IMG_GetError());
+        logWarn("can't load icon", logStr("error", IMG_GetError()));
     }
-
-
-    // Load textures
-    SDL_Texture* bgTexture = IMG_LoadTexture(renderer, "assets/sprites/bg.png");
-    SDL_Texture* birdTexture = IMG_LoadTexture(renderer, "assets/sprites/Bird.png");
-    SDL_Texture* birdDashTexture = IMG_LoadTexture(renderer, "assets/sprites/Bird_dash.png");
-    SDL_Texture* pipeTopTexture = IMG_LoadTexture(renderer, "assets/sprites/pipe_top.png");
-    SDL_Texture* pipeBottomTexture = IMG_LoadTexture(renderer, "assets/sprites/pipe_bottom.png");
-    SDL_Texture* restartTexture = IMG_LoadTexture(renderer, "assets/sprites/restart.png");
-    SDL_Texture* startTexture = IMG_LoadTexture(renderer, "assets/sprites/start.png");
+    startupMark(&startup, "icon.png");
+
+
+    // Rotated quads are slow on the software renderer; GPUs rotate for free
+    SDL_RendererInfo rendererInfo;
+    int haveInfo = renderer && SDL_GetRendererInfo(renderer, &rendererInfo) == 0;
+    if (haveInfo) logInfo("renderer", logStr("backend", backendName(backendKind)), logStr("driver", rendererInfo.name));
+    if (rotation < 0) rotation = haveInfo && (rendererInfo.flags & SDL_RENDERER_SOFTWARE);
+
+    // Load textures into one atlas
+    Atlas atlas;
+    SDL_zero(atlas);
+    if (renderer) atlasLoad(&atlas, renderer, &startup, rotation || backendKind == BACKEND_CPU ? ATLAS_KEEP_PIXELS : 0);
+    static CpuRenderer cpu;
+    if (backendKind == BACKEND_CPU) {
+        int outW, outH;
+        if (SDL_GetRendererOutputSize(renderer, &outW, &outH) != 0) { outW = WINDOW_WIDTH; outH = WINDOW_HEIGHT; }
+        if (cpuInit(&cpu, renderer, &atlas, outW, outH, cpuSimd, cpuThreads) != 0) {
+            logWarn("can't start the cpu renderer, drawing with SDL", logStr("error", SDL_GetError()));
+            backendKind = BACKEND_SDL;
+        }
+    }
+    static RotCache rotations; // the CPU renderer keeps its frames in memory
+    if (backendKind == BACKEND_CPU) rotCacheInit(&rotations, NULL, &atlas);
+    else if (rotation && renderer) rotCacheInit(&rotations, renderer, &atlas);
+    atlasReleasePixels(&atlas);
+    static MemReport mem; // F4 and --mem-report
+    memInit(&mem);
+    memAddTexture(&mem, "sprite atlas", atlas.texture);
+    memAddTexture(&mem, "bird rotations", rotations.texture);
+    memAddTexture(&mem, "cpu frame", cpu.texture);
+    memAddPixels(&mem, "cpu framebuffer", cpu.frame, cpu.w, cpu.h, 4);
+    memAddPixels(&mem, "cpu atlas", cpu.atlas, cpu.atlasPitch, cpu.atlasH, 4);
+    memAddPixels(&mem, "cpu background", cpu.background, cpu.w, cpu.h, 4);
+    memAddPixels(&mem, "bird rotations", rotations.pixels, rotations.columns * rotations.cellW, rotations.rows * rotations.cellH, 4);
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--texture-report") == 0) atlasPrintMemory(&atlas, stdout);
+    static FrameArena frameArena; // per-frame scratch, reset at the top of every loop iteration
+    if (arenaInit(&frameArena, FRAME_ARENA_SIZE) != 0) { logError("out of memory"); return 1; }
 
     // Initialize audio
-    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) printf("Mix_OpenAudio failed: %s\n", Mix_GetError());
+    if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) logWarn("Mix_OpenAudio failed", logStr("error", Mix_GetError()));
+    startupMark(&startup, "Mix_OpenAudio");
     Mix_Music* bgm = Mix_LoadMUS("assets/audio/bgm.mp3");
+    startupMark(&startup, "bgm.mp3");
     Mix_Chunk* jumpSfx = Mix_LoadWAV("assets/audio/jump.mp3");
+    startupMark(&startup, "jump.mp3");
     Mix_Chunk* dashSfx = Mix_LoadWAV("assets/audio/dash.mp3");
+    startupMark(&startup, "dash.mp3");
     Mix_Chunk* dedSfx  = Mix_LoadWAV("assets/audio/ded.mp3");
+    startupMark(&startup, "ded.mp3");
     Mix_Chunk* crossSfx = Mix_LoadWAV("assets/audio/cross.mp3");
+    startupMark(&startup, "cross.mp3");
+
+    if (bgm) memAddFile(&mem, MEM_MUSIC, "assets/audio/bgm.mp3");
+    memAddChunk(&mem, "jump.mp3", jumpSfx);
+    memAddChunk(&mem, "dash.mp3", dashSfx);
+    memAddChunk(&mem, "ded.mp3", dedSfx);
+    memAddChunk(&mem, "cross.mp3", crossSfx);
 
     if (bgm) { Mix_VolumeMusic(4); Mix_PlayMusic(bgm, -1); }
     if (jumpSfx) Mix_VolumeChunk(jumpSfx, 40);
@@ -83,52 +236,132 @@ int main(int argc, char* argv[]) {
     if (crossSfx) Mix_VolumeChunk(crossSfx, 40);
 
     TTF_Font* font = TTF_OpenFont("assets/fonts/Fraktur.ttf", 48);
-    if (!font) printf("Failed to load font: %s\n", TTF_GetError());
-
-    int running = 1, gameOver = 0, inMenu = 1;
+    if (!font) logWarn("can't load font", logStr("error", TTF_GetError()));
+    TTF_Font* smallFont = TTF_OpenFont("assets/fonts/Fraktur.ttf", 18);
+    startupMark(&startup, "fonts");
+    if (font) memAddFile(&mem, MEM_FONT, "assets/fonts/Fraktur.ttf");
+    if (smallFont) memAddFile(&mem, MEM_FONT, "assets/fonts/Fraktur.ttf");
+
+    TextCache textCache, overlayText; // the overlay's lines change every refresh; kept apart so they can't evict the HUD's
+    textCacheInit(&textCache, renderer);
+    textCacheInit(&overlayText, renderer);
+    const SDL_Color white = {255, 255, 255, 255};
+    DigitStrip scoreDigits; // the score changes mid-game, so it's drawn from prerendered digits
+    digitStripInit(&scoreDigits, renderer, font, white);
+    startupMark(&startup, "score digits");
+    memAddTexture(&mem, "score digits", scoreDigits.texture);
+    if (backendKind == BACKEND_CPU) cpuDigitsInit(&cpu, font);
+    memWatchTextCache(&mem, &textCache);
+    memWatchTextCache(&mem, &overlayText);
+
+    int running = 1, inMenu = 1;
     SDL_Event event;
 
-    float birdY = WINDOW_HEIGHT / 2, birdVelocity = 0;
-    const float gravity = 0.25f, flapStrength = -8.0f;
-    const int pipeSpeed = 3, dashSpeed = 12;
-    Pipe pipes[MAX_PIPES] = {0};
-    int pipeTimer = 0, score = 0, normalPipeCounter = 0, threePipeCooldown = 0;
+    GameState game;
+    gameReset(&game, sessionSeed);
+    GameState prevGame = game; // state one tick back, for render interpolation
+    if (playPath) {
+        inMenu = 0;
+        gameReset(&game, sessionSeed + gamesStarted++);
+        prevGame = game;
+    }
 
-    SDL_Rect birdRect = {250, (int)birdY, 106, 60};
-    SDL_Rect restartButton = {WINDOW_WIDTH/2 - 150, WINDOW_HEIGHT/2 - 50, 300, 100};
-    SDL_Rect startButton = {WINDOW_WIDTH/2 - 400, WINDOW_HEIGHT/2 - 100, 800, 200}; // Start button size
-    SDL_Texture* currentBirdTexture = birdTexture;
+    static RenderBackend backend;
+    RotCache* birdFrames = rotations.texture || rotations.pixels ? &rotations : NULL;
+    if (backendKind == BACKEND_CPU) backendInitCpu(&backend, &cpu, &atlas, birdFrames, font);
+    else if (backendKind == BACKEND_NULL) backendInitNull(&backend);
+    else backendInitSdl(&backend, renderer, &atlas, birdFrames, &frameArena, &textCache, &scoreDigits, font);
+    sceneWarmText(&backend); // so the first frame of play finds its labels cached
+    static SceneLayer staticLayer; // the CPU renderer draws static screens directly; it only composites when they change
+    if (backendKind == BACKEND_SDL) sceneLayerInit(&staticLayer, renderer);
+    memAddTexture(&mem, "static layer", staticLayer.texture);
     int dashChannel = -1;
 
+    int vsync = haveInfo && (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC);
+    const double tickSeconds = 1.0 / TICK_RATE;
+    const double counterFreq = (double)SDL_GetPerformanceFrequency();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+    double accumulator = 0;
+    int pendingFlap = 0; // survives render frames that don't run a tick
+    unsigned long renderedFrames = 0;
+    double totalFrameTime = 0, worstFrameTime = 0;
+
+    // Phase timings; --trace also streams them to a Chrome/Perfetto trace file
+    static Profiler profiler;
+    if (profInit(&profiler, tracePath) != 0) logWarn("can't open trace", logStr("path", tracePath));
+    int showProfiler = 0, dumpMemory = 0;
+    char profLines[OVERLAY_LINES][TEXT_CACHE_MAX_LEN] = {""};
+    AllocSnapshot frameAllocs = {0, 0};
+    static PerfCounters perf;
+    if (perfCounters) profAttachPerf(&profiler, &perf);
+    // Counters are always kept; --metrics PORT|unix:PATH serves them from a background thread
+    static Metrics metrics;
+    SDL_DisplayMode displayMode;
+    metricsInit(&metrics, SDL_GetWindowDisplayMode(window, &displayMode) == 0 ? displayMode.refresh_rate : 60);
+    if (metricsAddress && metricsServe(&metrics, metricsAddress) == 0) metricsAttachAudio(&metrics);
+    static FlightRecorder flight;
+    flightInit(&flight, hitchBudgetMs);
+
+    startupMark(&startup, "game and profiler");
+    if (renderer) warmSdlPools(renderer, &atlas, &frameArena);
+    startupMark(&startup, "warm SDL pools");
+    int redraw = 1; // a static screen needs presenting again
     while (running) {
-        int dash = 0;
+        // The menu and game over don't move: sleep until an event instead of presenting the same frame at the refresh rate
+        int idle = (inMenu || game.gameOver) && !playPath && !showProfiler;
+        int waited = 0;
+        if (idle && !redraw) {
+            SDL_WaitEventTimeout(NULL, IDLE_WAIT_MS); // NULL leaves the event queued for the loop below
+            lastCounter = SDL_GetPerformanceCounter(); // the wait is neither frame time nor simulation to catch up
+            accumulator = 0;
+            waited = 1;
+        }
+        arenaReset(&frameArena);
+        AllocSnapshot allocsBefore = allocStatsThread();
+        profFrameBegin(&profiler);
+        Uint64 now = SDL_GetPerformanceCounter();
+        double frameTime = (now - lastCounter) / counterFreq;
+        lastCounter = now;
+        if (renderedFrames > 0 && !waited) {
+            totalFrameTime += frameTime;
+            metricsFrame(&metrics, frameTime);
+            if (frameTime > worstFrameTime) worstFrameTime = frameTime;
+        }
+        renderedFrames++;
+        if (frameTime > MAX_FRAME_TIME) frameTime = MAX_FRAME_TIME;
+        accumulator += frameTime;
+        int sdlEvents = 0, ticks = 0, frameEvents = 0;
+
         while (SDL_PollEvent(&event)) {
+            sdlEvents++;
             if (event.type == SDL_QUIT) running = 0;
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F3) showProfiler = !showProfiler;
+            if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_F4) dumpMemory = 1;
+            if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) sceneLayerInvalidate(&staticLayer);
+            if (event.type == SDL_WINDOWEVENT || event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) redraw = 1;
+            if (playPath) continue;
 
             if (inMenu) {
                 if (event.type == SDL_MOUSEBUTTONDOWN) {
                     int mx = event.button.x;
                     int my = event.button.y;
-                    if (mx >= startButton.x && mx <= startButton.x + startButton.w &&
-                        my >= startButton.y && my <= startButton.y + startButton.h) {
+                    if (mx >= sceneStartButton.x && mx <= sceneStartButton.x + sceneStartButton.w &&
+                        my >= sceneStartButton.y && my <= sceneStartButton.y + sceneStartButton.h) {
                         inMenu = 0;
-                        resetGame(&birdY, &birdVelocity, pipes, &pipeTimer, &score, &normalPipeCounter, &threePipeCooldown);
+                        gameReset(&game, sessionSeed + gamesStarted++);
+                        prevGame = game;
                     }
                 }
             } else {
                 if (event.type == SDL_KEYDOWN) {
-                    if (!gameOver) {
-                        if (event.key.keysym.sym == SDLK_SPACE) {
-                            birdVelocity = flapStrength;
-                            if (jumpSfx) Mix_PlayChannel(-1, jumpSfx, 0);
-                        }
+                    if (!game.gameOver) {
+                        if (event.key.keysym.sym == SDLK_SPACE) pendingFlap = 1;
                         if ((event.key.keysym.sym == SDLK_LSHIFT || event.key.keysym.sym == SDLK_RSHIFT) && dashChannel == -1) {
-                            dash = 1;
                             if (dashSfx) dashChannel = Mix_PlayChannel(-1, dashSfx, -1);
                         }
                     } else if (event.key.keysym.sym == SDLK_r) {
-                        resetGame(&birdY, &birdVelocity, pipes, &pipeTimer, &score, &normalPipeCounter, &threePipeCooldown);
-                        gameOver = 0;
+                        gameReset(&game, sessionSeed + gamesStarted++);
+                        prevGame = game;
                     }
                 }
 
@@ -138,169 +371,164 @@ int main(int argc, char* argv[]) {
                     }
                 }
 
-                if (event.type == SDL_MOUSEBUTTONDOWN && gameOver) {
+                if (event.type == SDL_MOUSEBUTTONDOWN && game.gameOver) {
                     int mx = event.button.x;
                     int my = event.button.y;
-                    if (mx >= restartButton.x && mx <= restartButton.x + restartButton.w &&
-                        my >= restartButton.y && my <= restartButton.y + restartButton.h) {
-                        resetGame(&birdY, &birdVelocity, pipes, &pipeTimer, &score, &normalPipeCounter, &threePipeCooldown);
-                        gameOver = 0;
+                    if (mx >= sceneRestartButton.x && mx <= sceneRestartButton.x + sceneRestartButton.w &&
+                        my >= sceneRestartButton.y && my <= sceneRestartButton.y + sceneRestartButton.h) {
+                        gameReset(&game, sessionSeed + gamesStarted++);
+                        prevGame = game;
                     }
                 }
             }
         }
 
         const Uint8* state = SDL_GetKeyboardState(NULL);
-        int shiftHeld = state[SDL_SCANCODE_LSHIFT] || state[SDL_SCANCODE_RSHIFT];
-
-        if (!inMenu && !gameOver) {
-            int currentPipeSpeed = pipeSpeed;
-            if (shiftHeld) { birdVelocity = 0; currentPipeSpeed = dashSpeed; currentBirdTexture = birdDashTexture ? birdDashTexture : birdTexture; }
-            else { currentBirdTexture = birdTexture; }
-
-            if (!shiftHeld) birdVelocity += gravity;
-            birdY += birdVelocity;
-            birdRect.y = (int)birdY;
-
-            if (birdY <= 0 || birdY + birdRect.h >= WINDOW_HEIGHT) {
-                gameOver = 1;
-                if (dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
-            }
-
-            // --- Pipe spawning ---
-            pipeTimer++;
-            if (pipeTimer > 80) {
-                pipeTimer = 0;
-                if (threePipeCooldown > 0) { // normal pipe
-                    for (int i = 0; i < MAX_PIPES; i++) {
-                        if (!pipes[i].active) {
-                            pipes[i].active = 1;
-                            pipes[i].x = WINDOW_WIDTH;
-                            pipes[i].height = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                            pipes[i].scored = 0;
-                            break;
-                        }
-                    }
-                    threePipeCooldown--;
-                    normalPipeCounter++;
-                } else {
-                    if (normalPipeCounter >= 3 && rand() % 5 == 0) { // 3-row pipes
-                        int baseHeight = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                        for (int j = 0; j < 3; j++) {
-                            for (int i = 0; i < MAX_PIPES; i++) {
-                                if (!pipes[i].active) {
-                                    pipes[i].active = 1;
-                                    pipes[i].x = WINDOW_WIDTH + j * (PIPE_WIDTH + 10);
-                                    pipes[i].height = baseHeight;
-                                    pipes[i].scored = 0;
-                                    break;
-                                }
-                            }
-                        }
-                        normalPipeCounter = 0;
-                        threePipeCooldown = 3;
-                    } else { // normal pipe
-                        for (int i = 0; i < MAX_PIPES; i++) {
-                            if (!pipes[i].active) {
-                                pipes[i].active = 1;
-                                pipes[i].x = WINDOW_WIDTH;
-                                pipes[i].height = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                                pipes[i].scored = 0;
-                                break;
-                            }
-                        }
-                        normalPipeCounter++;
-                    }
+        GameInput input = {0, state[SDL_SCANCODE_LSHIFT] || state[SDL_SCANCODE_RSHIFT]};
+        profMark(&profiler, PHASE_EVENTS);
+
+        // Fixed-rate simulation; a flap is consumed by the next tick that runs
+        while (accumulator >= tickSeconds) {
+            accumulator -= tickSeconds;
+            prevGame = game;
+            if (playPath) {
+                int result = replayInput(&replay, &game, &input);
+                if (result == REPLAY_FINISHED) { running = 0; break; }
+                if (result == REPLAY_STEP && game.gameOver) { // died before the recording did
+                    replaySkipGame(&replay);
+                    result = REPLAY_GAME_OVER;
+                }
+                if (result == REPLAY_GAME_OVER) {
+                    if (game.score != replay.endScore)
+                        logWarn("replay desync", logInt("game", gamesStarted - 1), logInt("score", game.score), logInt("recorded", replay.endScore));
+                    gameReset(&game, sessionSeed + gamesStarted++);
+                    prevGame = game;
+                    continue;
                 }
+            } else {
+                if (inMenu || game.gameOver) { pendingFlap = 0; continue; }
+                input.flap = pendingFlap;
+                pendingFlap = 0;
+                if (recordPath) replayRecordInput(&replay, &game, input);
             }
 
-            // Move pipes & check collisions
-            for (int i = 0; i < MAX_PIPES; i++) {
-                if (pipes[i].active) {
-                    pipes[i].x -= currentPipeSpeed;
-
-                    SDL_Rect topPipe = {pipes[i].x, 0, PIPE_WIDTH, pipes[i].height};
-                    SDL_Rect bottomPipe = {pipes[i].x, pipes[i].height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - pipes[i].height - PIPE_GAP};
-                    SDL_Rect scoreZone = {pipes[i].x + PIPE_WIDTH / 2, 0, 1, WINDOW_HEIGHT};
-
-                    if (checkCollision(birdRect, topPipe) || checkCollision(birdRect, bottomPipe)) {
-                        gameOver = 1;
-                        if (dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
-                    }
-
-                    if (!pipes[i].scored && checkCollision(birdRect, scoreZone)) {
-                        score++;
-                        pipes[i].scored = 1;
-                        if (crossSfx) Mix_PlayChannel(-1, crossSfx, 0);
-                    }
-
-                    if (pipes[i].x + PIPE_WIDTH < 0) pipes[i].active = 0;
-                }
+            // gameStep, one phase at a time
+            if (game.gameOver) continue;
+            int events = gameStepBird(&game, input);
+            profMark(&profiler, PHASE_SIM);
+            gameStepSpawn(&game);
+            profMark(&profiler, PHASE_SPAWN);
+            events |= gameStepPipes(&game);
+            profMark(&profiler, PHASE_COLLISION);
+            ticks++;
+            frameEvents |= events;
+
+            if (recordPath && (events & GAME_EVENT_DIED)) replayEndGame(&replay, &game);
+            if ((events & GAME_EVENT_FLAP) && jumpSfx) Mix_PlayChannel(-1, jumpSfx, 0);
+            if ((events & GAME_EVENT_SCORE) && crossSfx) Mix_PlayChannel(-1, crossSfx, 0);
+            if ((events & GAME_EVENT_DIED) && dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
+            if (events & GAME_EVENT_DIED) {
+                metricsDeath(&metrics, game.score);
+                logDebug("game over", logInt("score", game.score), logInt("ticks", (long long)game.frame));
             }
+            profMark(&profiler, PHASE_AUDIO);
         }
+        profMark(&profiler, PHASE_SIM);
+        float alpha = (float)(accumulator / tickSeconds);
 
         // --- Rendering ---
-        SDL_RenderClear(renderer);
-        if (bgTexture) SDL_RenderCopy(renderer, bgTexture, NULL, NULL);
-
-        if (inMenu) {
-            if (startTexture) SDL_RenderCopy(renderer, startTexture, NULL, &startButton);
-            // Tips bottom-right
-            if (font) {
-                SDL_Color white = {255, 255, 255, 255};
-
-                SDL_Surface* creditSurf = TTF_RenderText_Solid(font, "Assets made by Wish Techawashira", white);
-                SDL_Texture* creditTex = SDL_CreateTextureFromSurface(renderer, creditSurf);
-                SDL_Rect creditRect = {20, WINDOW_HEIGHT - creditSurf->h - 20, creditSurf->w, creditSurf->h};
-                SDL_RenderCopy(renderer, creditTex, NULL, &creditRect);
-                SDL_FreeSurface(creditSurf);
-                SDL_DestroyTexture(creditTex);
+        // Static screens present once, then again only after a window or render device event
+        idle = (inMenu || game.gameOver) && !playPath && !showProfiler;
+        int present = !idle || redraw;
+        if (present) {
+            // On SDL sprites go out as one SDL_RenderGeometry batch; cached text is drawn on top.
+            // Static screens come from the layer cache, text included.
+            backend.begin(&backend);
+            if (inMenu || game.gameOver) {
+                sceneDrawStatic(&backend, &staticLayer, inMenu, &game);
+                profMark(&profiler, PHASE_RENDER);
+            } else {
+                sceneDrawSprites(&backend, inMenu, &game, &prevGame, alpha);
+                profMark(&profiler, PHASE_RENDER);
+                sceneDrawText(&backend, inMenu, &game);
             }
-        } else {
-            // Draw pipes
-            for (int i = 0; i < MAX_PIPES; i++) {
-                if (pipes[i].active) {
-                    SDL_Rect top = {pipes[i].x, 0, PIPE_WIDTH, pipes[i].height};
-                    SDL_Rect bottom = {pipes[i].x, pipes[i].height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - pipes[i].height - PIPE_GAP};
-                    if (pipeTopTexture) SDL_RenderCopy(renderer, pipeTopTexture, NULL, &top);
-                    if (pipeBottomTexture) SDL_RenderCopy(renderer, pipeBottomTexture, NULL, &bottom);
+            profMark(&profiler, PHASE_TEXT);
+            backend.flush(&backend); // the CPU backend composites and uploads here, counted as rendering
+            profMark(&profiler, PHASE_RENDER);
+
+            if (showProfiler && smallFont && renderer) {
+                // Refresh the numbers a few times a second so the text cache isn't churned every frame
+                if (profiler.frame % 30 == 1 || profLines[0][0] == '\0') {
+                    ProfStats stats[PHASE_COUNT + 1];
+                    profStats(&profiler, stats);
+                    snprintf(profLines[0], TEXT_CACHE_MAX_LEN, "phase        avg ms    p99 ms");
+                    for (int i = 0; i <= PHASE_COUNT; i++)
+                        snprintf(profLines[i + 1], TEXT_CACHE_MAX_LEN, "%-10s %7.3f  %7.3f", profPhaseName(i), stats[i].avgMs, stats[i].p99Ms);
+                    snprintf(profLines[PHASE_COUNT + 2], TEXT_CACHE_MAX_LEN, "heap %lu allocs %llu B, arena %lu KB",
+                        frameAllocs.count, frameAllocs.bytes, (unsigned long)(frameArena.peak / 1024));
                 }
+                drawProfilerOverlay(renderer, &overlayText, smallFont, profLines);
             }
-
-            float angle = -birdVelocity * 3.0f;
-            if (angle > 45.0f) angle = 45.0f;
-            if (angle < -45.0f) angle = -45.0f;
-            SDL_RenderCopyEx(renderer, currentBirdTexture, NULL, &birdRect, angle, NULL, SDL_FLIP_NONE);
-
-            // Draw score
-            if (font) {
-                char scoreStr[16];
-                sprintf(scoreStr, "Score: %d", score);
-                SDL_Color white = {255, 255, 255, 255};
-                SDL_Surface* scoreSurf = TTF_RenderText_Solid(font, scoreStr, white);
-                SDL_Texture* scoreTex = SDL_CreateTextureFromSurface(renderer, scoreSurf);
-                SDL_Rect scoreRect = {WINDOW_WIDTH/2 - scoreSurf->w/2, 20, scoreSurf->w, scoreSurf->h};
-                SDL_RenderCopy(renderer, scoreTex, NULL, &scoreRect);
-                SDL_FreeSurface(scoreSurf);
-                SDL_DestroyTexture(scoreTex);
+            profMark(&profiler, PHASE_TEXT);
+
+            backend.present(&backend);
+            profMark(&profiler, PHASE_PRESENT);
+            if (renderedFrames == 1) {
+                startupMark(&startup, "first frame");
+                if (startupReport) startupPrint(&startup, stdout);
+                if (exitAfterFirstFrame) { fflush(stdout); _Exit(0); } // --startup-bench child: skip teardown
             }
+            redraw = !idle; // a frame of play leaves the next static screen to be shown
+        } else {
+            profMark(&profiler, PHASE_PRESENT);
+        }
+        if (!vsync) SDL_Delay(1); // don't spin a core when present doesn't block
+        profMark(&profiler, PHASE_SLEEP);
+        metricsPresent(&metrics, present, idle);
+        int dumped = flightRecord(&flight, &profiler, sdlEvents, ticks, frameEvents, inMenu ? 0 : game.pipeCount);
+        memSample(&mem);
+        metricsSessions(&metrics, gamesStarted);
+        if (dumpMemory) {
+            memDump(&mem, profiler.frame);
+            dumpMemory = 0;
+            dumped = 1;
+        }
 
-            // Restart button if game over
-            if (gameOver && restartTexture) SDL_RenderCopy(renderer, restartTexture, NULL, &restartButton);
+        // Steady-state play must not touch the heap (the F3 overlay's text and hitch/memory dumps aside)
+        AllocSnapshot allocsAfter = allocStatsThread();
+        frameAllocs.count = allocsAfter.count - allocsBefore.count;
+        frameAllocs.bytes = allocsAfter.bytes - allocsBefore.bytes;
+        if (!inMenu && !game.gameOver && !showProfiler && !dumped && frameAllocs.count > 0) {
+            logWarn("frame allocated while playing", logInt("frame", profiler.frame), logInt("allocs", (long long)frameAllocs.count),
+                logInt("bytes", (long long)frameAllocs.bytes));
+            SDL_assert(frameAllocs.count == 0);
         }
+    }
+    profShutdown(&profiler);
+    flightShutdown(&flight);
+    metricsStop(&metrics);
+    if (profiler.perf) {
+        perfPrint(&perf, stdout);
+        perfClose(&perf);
+    }
 
-        SDL_RenderPresent(renderer);
-        SDL_Delay(16);
+    if (playPath) {
+        logInfo("replay finished", logStr("path", playPath), logInt("games", gamesStarted), logInt("frames", (long long)renderedFrames),
+            logNum("avg_ms", renderedFrames > 1 ? totalFrameTime * 1000 / (renderedFrames - 1) : 0.0), logNum("worst_ms", worstFrameTime * 1000));
+    } else if (recordPath) {
+        if (!inMenu && !game.gameOver) replayEndGame(&replay, &game); // quit mid-game
+        if (replaySave(&replay, recordPath) != 0) logError("can't write replay", logStr("path", recordPath));
     }
+    replayFree(&replay);
+    if (backendKind == BACKEND_NULL)
+        logInfo("null renderer", logInt("frames", (long long)backend.frames), logInt("sprites", (long long)backend.sprites),
+            logInt("texts", (long long)backend.texts));
+    if (memReport) memPrint(&mem, stdout);
 
     // Cleanup
-    if (birdTexture) SDL_DestroyTexture(birdTexture);
-    if (birdDashTexture) SDL_DestroyTexture(birdDashTexture);
-    if (bgTexture) SDL_DestroyTexture(bgTexture);
-    if (pipeTopTexture) SDL_DestroyTexture(pipeTopTexture);
-    if (pipeBottomTexture) SDL_DestroyTexture(pipeBottomTexture);
-    if (restartTexture) SDL_DestroyTexture(restartTexture);
-    if (startTexture) SDL_DestroyTexture(startTexture);
+    atlasDestroy(&atlas);
+    rotCacheFree(&rotations);
+    cpuFree(&cpu);
 
     if (bgm) Mix_FreeMusic(bgm);
     if (jumpSfx) Mix_FreeChunk(jumpSfx);
@@ -308,11 +536,18 @@ int main(int argc, char* argv[]) {
     if (dedSfx) Mix_FreeChunk(dedSfx);
     if (crossSfx) Mix_FreeChunk(crossSfx);
     Mix_CloseAudio();
+    textCacheClear(&textCache);
+    textCacheClear(&overlayText);
+    digitStripFree(&scoreDigits);
+    sceneLayerFree(&staticLayer);
+    arenaFree(&frameArena);
     TTF_CloseFont(font);
+    if (smallFont) TTF_CloseFont(smallFont);
     TTF_Quit();
     IMG_Quit();
-    SDL_DestroyRenderer(renderer);
+    if (renderer) SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     SDL_Quit();
+    if (profilePath) samplerStop(profilePath);
     return 0;
 }
@@ -0,0 +1,163 @@
+#include "memreport.h"
+#include "log.h"
+#include <string.h>
+#ifdef _WIN32
+#define PSAPI_VERSION 2 // GetProcessMemoryInfo from kernel32, no -lpsapi
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__linux__)
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#define RSS_TIMELINE_POINTS 12
+
+static const char* kindNames[MEM_KINDS] = {"texture", "audio", "music", "font", "buffer"};
+
+void memInit(MemReport* m) {
+    memset(m, 0, sizeof(*m));
+}
+
+static MemItem* addItem(MemReport* m, int kind, const char* name) {
+    if (m->count >= MEM_MAX_ITEMS) return NULL;
+    MemItem* item = &m->items[m->count++];
+    item->kind = kind;
+    snprintf(item->name, sizeof(item->name), "%s", name);
+    return item;
+}
+
+static unsigned long long textureBytes(SDL_Texture* texture, char* detail, size_t size) {
+    Uint32 format;
+    int w, h;
+    if (!texture || SDL_QueryTexture(texture, &format, NULL, &w, &h) != 0) return 0;
+    int bpp = SDL_BYTESPERPIXEL(format);
+    snprintf(detail, size, "%dx%d %dbpp", w, h, bpp * 8);
+    return (unsigned long long)w * h * bpp;
+}
+
+void memAddTexture(MemReport* m, const char* name, SDL_Texture* texture) {
+    MemItem* item = texture ? addItem(m, MEM_TEXTURE, name) : NULL;
+    if (item) item->bytes = textureBytes(texture, item->detail, sizeof(item->detail));
+}
+
+void memAddChunk(MemReport* m, const char* name, const Mix_Chunk* chunk) {
+    MemItem* item = chunk ? addItem(m, MEM_AUDIO, name) : NULL;
+    if (!item) return;
+    item->bytes = chunk->alen;
+    int freq, channels;
+    Uint16 format;
+    if (Mix_QuerySpec(&freq, &format, &channels)) {
+        double seconds = (double)chunk->alen / ((double)freq * channels * (SDL_AUDIO_BITSIZE(format) / 8));
+        snprintf(item->detail, sizeof(item->detail), "%.1f s PCM", seconds);
+    }
+}
+
+void memAddPixels(MemReport* m, const char* name, const void* pixels, int w, int h, int bpp) {
+    MemItem* item = pixels ? addItem(m, MEM_BUFFER, name) : NULL;
+    if (!item) return;
+    snprintf(item->detail, sizeof(item->detail), "%dx%d %dbpp", w, h, bpp * 8);
+    item->bytes = (unsigned long long)w * h * bpp;
+}
+
+void memAddFile(MemReport* m, int kind, const char* path) {
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if (!rw) return;
+    Sint64 size = SDL_RWsize(rw);
+    SDL_RWclose(rw);
+    MemItem* item = addItem(m, kind, path);
+    if (!item) return;
+    const char* base = strrchr(path, '/');
+    snprintf(item->name, sizeof(item->name), "%s", base ? base + 1 : path);
+    snprintf(item->detail, sizeof(item->detail), "file, streamed");
+    item->bytes = size > 0 ? (unsigned long long)size : 0;
+}
+
+void memWatchTextCache(MemReport* m, const TextCache* c) {
+    if (m->textCacheCount < MEM_TEXT_CACHES) m->textCaches[m->textCacheCount++] = c;
+}
+
+unsigned long long memRss(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.WorkingSetSize;
+    return 0;
+#elif defined(__linux__)
+    // statm: "size resident shared ..." in pages; read() so the main loop stays off the heap
+    char buf[128];
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    char* p = strchr(buf, ' ');
+    return p ? strtoull(p + 1, NULL, 10) * (unsigned long long)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+void memSample(MemReport* m) {
+    Uint64 now = SDL_GetTicks64();
+    if (m->rssCount > 0 && now < m->nextSample) return;
+    m->nextSample = now + 1000;
+    Uint32 kb = (Uint32)(memRss() / 1024);
+    unsigned long slot = m->rssCount++ % MEM_RSS_SAMPLES;
+    m->rssKb[slot] = kb;
+    m->rssSeconds[slot] = (Uint32)(now / 1000);
+    if (kb > m->peakRssKb) m->peakRssKb = kb;
+}
+
+static void printItem(FILE* out, const char* kind, const char* name, const char* detail, unsigned long long bytes) {
+    fprintf(out, "%-8s %-34s %-18s %9.1f\n", kind, name, detail, bytes / 1024.0);
+}
+
+void memPrint(const MemReport* m, FILE* out) {
+    unsigned long long totals[MEM_KINDS] = {0};
+    char detail[32];
+    fprintf(out, "%-8s %-34s %-18s %9s\n", "kind", "name", "detail", "KB");
+    for (int i = 0; i < m->count; i++) {
+        const MemItem* item = &m->items[i];
+        printItem(out, kindNames[item->kind], item->name, item->detail, item->bytes);
+        totals[item->kind] += item->bytes;
+    }
+    for (int i = 0; i < m->textCacheCount * TEXT_CACHE_SIZE; i++) {
+        const TextCacheEntry* e = &m->textCaches[i / TEXT_CACHE_SIZE]->entries[i % TEXT_CACHE_SIZE];
+        if (!e->lastUsed) continue;
+        unsigned long long bytes = textureBytes(e->texture, detail, sizeof(detail));
+        char name[48];
+        snprintf(name, sizeof(name), "text \"%s\"", e->text);
+        printItem(out, kindNames[MEM_TEXTURE], name, detail, bytes);
+        totals[MEM_TEXTURE] += bytes;
+    }
+    fprintf(out, "total: textures %.1f KB, decoded audio %.1f KB, music files %.1f KB, font files %.1f KB\n",
+        totals[MEM_TEXTURE] / 1024.0, totals[MEM_AUDIO] / 1024.0, totals[MEM_MUSIC] / 1024.0, totals[MEM_FONT] / 1024.0);
+
+    unsigned long long rss = memRss();
+    if (rss == 0) return;
+    fprintf(out, "RSS now %.1f MB, peak %.1f MB sampled\n", rss / 1048576.0, m->peakRssKb / 1024.0);
+    if (m->rssCount == 0) return;
+    // Evenly spaced points across the samples still in the ring
+    unsigned long first = m->rssCount > MEM_RSS_SAMPLES ? m->rssCount - MEM_RSS_SAMPLES : 0;
+    unsigned long span = m->rssCount - first;
+    int points = span < RSS_TIMELINE_POINTS ? (int)span : RSS_TIMELINE_POINTS;
+    fprintf(out, "RSS over time:");
+    for (int k = 0; k < points; k++) {
+        unsigned long i = first + (points > 1 ? k * (span - 1) / (points - 1) : 0);
+        unsigned long slot = i % MEM_RSS_SAMPLES;
+        fprintf(out, " %us=%.1fMB", (unsigned)m->rssSeconds[slot], m->rssKb[slot] / 1024.0);
+    }
+    fprintf(out, "\n");
+}
+
+int memDump(const MemReport* m, unsigned int frame) {
+    char path[64];
+    snprintf(path, sizeof(path), "mem_%u.txt", frame);
+    FILE* f = fopen(path, "w");
+    if (!f) { logError("can't write memory report", logStr("path", path)); return -1; }
+    memPrint(m, f);
+    fclose(f);
+    logInfo("memory report written", logStr("path", path));
+    return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef MEMREPORT_H
+#define MEMREPORT_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <stdio.h>
+#include "textcache.h"
+
+/*
+   Where the memory goes: every texture we hold (w x h x bytes per pixel),
+   the CPU renderer's pixel buffers, every Mix_Chunk's decoded PCM, the font and music files, and the process
+   RSS sampled once a second. Assets are registered as they load; the text
+   cache is walked at report time since its textures come and go. F4 dumps
+   the report to mem_<frame>.txt, --mem-report prints it at exit.
+
+   Music and fonts are streamed from their files, so what's listed for them
+   is the file size: an upper bound on what the decoders keep around.
+*/
+
+#define MEM_MAX_ITEMS 32
+#define MEM_TEXT_CACHES 2 // the HUD's and the profiler overlay's
+#define MEM_RSS_SAMPLES 600 // ten minutes at one sample a second; older ones are overwritten
+
+enum {
+    MEM_TEXTURE,
+    MEM_AUDIO,
+    MEM_MUSIC,
+    MEM_FONT,
+    MEM_BUFFER,
+    MEM_KINDS
+};
+
+typedef struct {
+    int kind;
+    char name[48];
+    char detail[32];
+    unsigned long long bytes;
+} MemItem;
+
+typedef struct {
+    MemItem items[MEM_MAX_ITEMS];
+    int count;
+    const TextCache* textCaches[MEM_TEXT_CACHES];
+    int textCacheCount;
+    Uint32 rssKb[MEM_RSS_SAMPLES];
+    Uint32 rssSeconds[MEM_RSS_SAMPLES];
+    unsigned long rssCount;
+    Uint32 peakRssKb;
+    Uint64 nextSample; // SDL_GetTicks64: the 32-bit tick count wraps after 49 days
+} MemReport;
+
+void memInit(MemReport* m);
+void memAddTexture(MemReport* m, const char* name, SDL_Texture* texture);
+void memAddChunk(MemReport* m, const char* name, const Mix_Chunk* chunk);
+/* Pixels the CPU renderer keeps in memory, w x h at bpp bytes each; nothing
+   when pixels is NULL. */
+void memAddPixels(MemReport* m, const char* name, const void* pixels, int w, int h, int bpp);
+/* A music or font file, listed by file size. */
+void memAddFile(MemReport* m, int kind, const char* path);
+/* Text cache textures are listed as they are when the report is printed;
+   up to MEM_TEXT_CACHES caches. */
+void memWatchTextCache(MemReport* m, const TextCache* c);
+
+/* Takes an RSS sample if a second has passed since the last; call every frame.
+   Reads /proc without touching the heap. */
+void memSample(MemReport* m);
+/* Resident set size in bytes, or 0 where unknown. */
+unsigned long long memRss(void);
+
+void memPrint(const MemReport* m, FILE* out);
+/* Writes mem_<frame>.txt; returns 0 on success. */
+int memDump(const MemReport* m, unsigned int frame);
+
+#endif
@@ -0,0 +1,285 @@
+#include "metrics.h"
+#include "log.h"
+#include <SDL2/SDL_mixer.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET Socket;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closeSocket close
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define METRICS_PAGE_SIZE 8192
+
+static const double frameBounds[METRICS_FRAME_BUCKETS - 1] = {0.004, 0.008, 0.0167, 0.020, 0.0333, 0.050, 0.100, 0.250};
+static const int scoreBounds[METRICS_SCORE_BUCKETS - 1] = {0, 1, 2, 5, 10, 20, 50, 100};
+
+void metricsInit(Metrics* m, int refreshHz) {
+    memset(m, 0, sizeof(*m));
+    m->refreshSeconds = 1.0 / (refreshHz > 0 ? refreshHz : 60);
+    m->fpsWindowStart = SDL_GetPerformanceCounter();
+    m->listenSocket = (intptr_t)INVALID_SOCKET;
+}
+
+void metricsFrame(Metrics* m, double seconds) {
+    int b = 0;
+    while (b < METRICS_FRAME_BUCKETS - 1 && seconds > frameBounds[b]) b++;
+    atomic_fetch_add_explicit(&m->frameBuckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->frames, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->frameMicros, (unsigned long long)(seconds * 1e6), memory_order_relaxed);
+    // Dropped frames counts refresh intervals missed, not long frames
+    if (seconds > METRICS_DROP_FACTOR * m->refreshSeconds)
+        atomic_fetch_add_explicit(&m->droppedFrames, (unsigned long)(seconds / m->refreshSeconds + 0.5) - 1, memory_order_relaxed);
+}
+
+void metricsPresent(Metrics* m, int presented, int idle) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (idle != m->fpsWindowIdle) {
+        m->fpsWindowIdle = idle;
+        m->fpsWindowStart = now;
+        m->fpsWindowFrames = 0;
+    }
+    if (presented) m->fpsWindowFrames++;
+    double elapsed = (double)(now - m->fpsWindowStart) / SDL_GetPerformanceFrequency();
+    if (elapsed >= 1.0) {
+        atomic_store_explicit(&m->fpsMilli, (unsigned)(m->fpsWindowFrames / elapsed * 1000), memory_order_relaxed);
+        m->fpsWindowStart = now;
+        m->fpsWindowFrames = 0;
+    }
+}
+
+void metricsSessions(Metrics* m, unsigned long sessions) {
+    atomic_store_explicit(&m->sessions, sessions, memory_order_relaxed);
+}
+
+void metricsDeath(Metrics* m, int score) {
+    int b = 0;
+    while (b < METRICS_SCORE_BUCKETS - 1 && score > scoreBounds[b]) b++;
+    atomic_fetch_add_explicit(&m->scoreBuckets[b], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->scoreSum, (unsigned long long)score, memory_order_relaxed);
+    atomic_fetch_add_explicit(&m->deaths, 1, memory_order_relaxed);
+}
+
+/* Mixer post-mix hook, on the audio thread. SDL_mixer doesn't report
+   underruns, so a buffer asked for much later than the previous one's
+   length is counted as one: the device ran dry in between. */
+static void onMix(void* data, Uint8* stream, int len) {
+    (void)stream;
+    Metrics* m = data;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (m->lastMix && m->mixBytesPerSecond > 0) {
+        double gap = (double)(now - m->lastMix) / SDL_GetPerformanceFrequency();
+        if (gap > METRICS_DROP_FACTOR * len / m->mixBytesPerSecond)
+            atomic_fetch_add_explicit(&m->audioUnderruns, 1, memory_order_relaxed);
+    }
+    m->lastMix = now;
+}
+
+void metricsAttachAudio(Metrics* m) {
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels)) return;
+    m->mixBytesPerSecond = (double)freq * channels * (SDL_AUDIO_BITSIZE(format) / 8);
+    Mix_SetPostMix(onMix, m);
+}
+
+static int append(char* buf, int size, int len, const char* fmt, ...) {
+    if (len >= size) return len;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf + len, size - len, fmt, args);
+    va_end(args);
+    return n < 0 ? len : (len + n < size ? len + n : size - 1);
+}
+
+static unsigned long load(atomic_ulong* v) {
+    return atomic_load_explicit(v, memory_order_relaxed);
+}
+
+int metricsFormat(Metrics* m, char* buf, int size) {
+    int len = 0;
+    unsigned long cumulative = 0;
+    len = append(buf, size, len, "# HELP froppy_frame_seconds Wall time of each rendered frame.\n# TYPE froppy_frame_seconds histogram\n");
+    for (int b = 0; b < METRICS_FRAME_BUCKETS; b++) {
+        cumulative += load(&m->frameBuckets[b]);
+        if (b < METRICS_FRAME_BUCKETS - 1) len = append(buf, size, len, "froppy_frame_seconds_bucket{le=\"%g\"} %lu\n", frameBounds[b], cumulative);
+        else len = append(buf, size, len, "froppy_frame_seconds_bucket{le=\"+Inf\"} %lu\n", cumulative);
+    }
+    len = append(buf, size, len, "froppy_frame_seconds_sum %.6f\nfroppy_frame_seconds_count %lu\n",
+        atomic_load_explicit(&m->frameMicros, memory_order_relaxed) / 1e6, cumulative);
+
+    len = append(buf, size, len, "# HELP froppy_fps Frames rendered over the last second.\n# TYPE froppy_fps gauge\nfroppy_fps %.3f\n",
+        atomic_load_explicit(&m->fpsMilli, memory_order_relaxed) / 1000.0);
+    len = append(buf, size, len, "# HELP froppy_dropped_frames_total Display refresh intervals missed.\n"
+        "# TYPE froppy_dropped_frames_total counter\nfroppy_dropped_frames_total %lu\n", load(&m->droppedFrames));
+    len = append(buf, size, len, "# HELP froppy_sessions_started_total Games started.\n"
+        "# TYPE froppy_sessions_started_total counter\nfroppy_sessions_started_total %lu\n", load(&m->sessions));
+    len = append(buf, size, len, "# HELP froppy_deaths_total Games ended by a crash.\n"
+        "# TYPE froppy_deaths_total counter\nfroppy_deaths_total %lu\n", load(&m->deaths));
+
+    cumulative = 0;
+    len = append(buf, size, len, "# HELP froppy_score Final score of each game.\n# TYPE froppy_score histogram\n");
+    for (int b = 0; b < METRICS_SCORE_BUCKETS; b++) {
+        cumulative += load(&m->scoreBuckets[b]);
+        if (b < METRICS_SCORE_BUCKETS - 1) len = append(buf, size, len, "froppy_score_bucket{le=\"%d\"} %lu\n", scoreBounds[b], cumulative);
+        else len = append(buf, size, len, "froppy_score_bucket{le=\"+Inf\"} %lu\n", cumulative);
+    }
+    len = append(buf, size, len, "froppy_score_sum %llu\nfroppy_score_count %lu\n",
+        atomic_load_explicit(&m->scoreSum, memory_order_relaxed), cumulative);
+
+    len = append(buf, size, len, "# HELP froppy_audio_underruns_total Mixer buffers filled late.\n"
+        "# TYPE froppy_audio_underruns_total counter\nfroppy_audio_underruns_total %lu\n", load(&m->audioUnderruns));
+    return len;
+}
+
+static void sendAll(Socket s, const char* data, int len) {
+    while (len > 0) {
+        int n = (int)send(s, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return;
+        data += n;
+        len -= n;
+    }
+}
+
+/* Answers every connection with the page, whatever it asked for. */
+static int serve(void* data) {
+    Metrics* m = data;
+    Socket listener = (Socket)m->listenSocket;
+    static char page[METRICS_PAGE_SIZE]; // only this thread touches it
+    char request[1024], header[160];
+
+    while (!atomic_load(&m->stop)) {
+        // Wake up a few times a second to notice metricsStop
+        fd_set ready;
+        FD_ZERO(&ready);
+        FD_SET(listener, &ready);
+        struct timeval wait = {0, 200000};
+        if (select((int)listener + 1, &ready, NULL, NULL, &wait) <= 0) continue;
+        Socket client = accept(listener, NULL, NULL);
+        if (client == INVALID_SOCKET) continue;
+
+#ifdef _WIN32
+        DWORD timeout = 1000;
+#else
+        struct timeval timeout = {1, 0};
+#endif
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+        recv(client, request, sizeof(request), 0); // the request line and headers, ignored
+
+        int len = metricsFormat(m, page, sizeof(page));
+        int headerLen = snprintf(header, sizeof(header),
+            "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\nConnection: close\r\n\r\n", len);
+        sendAll(client, header, headerLen);
+        sendAll(client, page, len);
+        closeSocket(client);
+    }
+    return 0;
+}
+
+static Socket listenTcp(int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // never reachable from outside the machine
+    Socket s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return s;
+    int on = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 8) != 0) {
+        closeSocket(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+
+#ifndef _WIN32
+static Socket listenUnix(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) return INVALID_SOCKET;
+    strcpy(addr.sun_path, path);
+    unlink(path); // left behind by a previous run
+    Socket s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET) return s;
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 8) != 0) {
+        close(s);
+        return INVALID_SOCKET;
+    }
+    return s;
+}
+#endif
+
+int metricsServe(Metrics* m, const char* address) {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) { logError("metrics: WSAStartup failed"); return -1; }
+#endif
+    Socket s;
+    if (strncmp(address, "unix:", 5) == 0) {
+#ifdef _WIN32
+        logError("metrics: unix sockets aren't supported here, use a port");
+        WSACleanup();
+        return -1;
+#else
+        s = listenUnix(address + 5);
+        if (s != INVALID_SOCKET) snprintf(m->socketPath, sizeof(m->socketPath), "%s", address + 5);
+#endif
+    } else {
+        s = listenTcp(atoi(address));
+    }
+    if (s == INVALID_SOCKET) {
+        logError("metrics: can't listen", logStr("address", address));
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return -1;
+    }
+
+    m->listenSocket = (intptr_t)s;
+    atomic_init(&m->stop, 0);
+    m->server = SDL_CreateThread(serve, "metrics", m);
+    if (!m->server) {
+        logError("metrics: can't start server thread", logStr("error", SDL_GetError()));
+        metricsStop(m);
+        return -1;
+    }
+    logInfo("metrics: serving", logStr("address", address));
+    return 0;
+}
+
+void metricsStop(Metrics* m) {
+    if ((Socket)m->listenSocket == INVALID_SOCKET) return;
+    if (m->server) {
+        atomic_store(&m->stop, 1);
+        SDL_WaitThread(m->server, NULL);
+        m->server = NULL;
+    }
+    closeSocket((Socket)m->listenSocket);
+    m->listenSocket = (intptr_t)INVALID_SOCKET;
+#ifdef _WIN32
+    WSACleanup();
+#else
+    if (m->socketPath[0]) unlink(m->socketPath);
+#endif
+    m->socketPath[0] = '\0';
+    Mix_SetPostMix(NULL, NULL);
+}
@@ -0,0 +1,66 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+   Live counters for the kiosk fleet, served as a Prometheus text page
+   (over plain HTTP) on a localhost TCP port or a Unix domain socket. The
+   main loop and the audio callback only do relaxed atomic adds and stores;
+   a background thread accepts scrapes and formats the page, so a slow
+   scraper never holds up a frame. A page is not one atomic snapshot: a
+   frame landing mid-scrape can show in some series and not yet in others.
+*/
+
+#define METRICS_FRAME_BUCKETS 9 // the last is +Inf
+#define METRICS_SCORE_BUCKETS 9
+#define METRICS_DROP_FACTOR 1.5 // a frame this many refresh intervals long missed at least one
+
+typedef struct {
+    atomic_ulong frameBuckets[METRICS_FRAME_BUCKETS]; // per bucket, not cumulative
+    atomic_ulong frames, droppedFrames, sessions, deaths, audioUnderruns;
+    atomic_ullong frameMicros; // sum of frame times
+    atomic_ulong scoreBuckets[METRICS_SCORE_BUCKETS];
+    atomic_ullong scoreSum;
+    atomic_uint fpsMilli;
+
+    // Main thread only
+    double refreshSeconds;
+    Uint64 fpsWindowStart;
+    unsigned long fpsWindowFrames;
+    int fpsWindowIdle;
+
+    // Audio thread only
+    Uint64 lastMix;
+    double mixBytesPerSecond;
+
+    intptr_t listenSocket; // a SOCKET on Windows
+    char socketPath[108]; // unix: address, removed again on stop
+    SDL_Thread* server;
+    atomic_int stop;
+} Metrics;
+
+/* Zeroes the counters; refreshHz sets what counts as a dropped frame. */
+void metricsInit(Metrics* m, int refreshHz);
+/* Serves the page on address: a port number on 127.0.0.1, or unix:PATH.
+   Returns 0 on success; on failure prints why and nothing is served. */
+int metricsServe(Metrics* m, const char* address);
+void metricsStop(Metrics* m);
+/* Counts audio underruns from the gaps between mixer callbacks. Call after Mix_OpenAudio. */
+void metricsAttachAudio(Metrics* m);
+
+void metricsFrame(Metrics* m, double seconds);
+/* Call every loop pass, presented or not, so froppy_fps follows a static
+   screen that only presents when it changes. idle restarts the window when
+   it changes: play and static screens aren't averaged together. */
+void metricsPresent(Metrics* m, int presented, int idle);
+/* Games started so far this session. */
+void metricsSessions(Metrics* m, unsigned long sessions);
+void metricsDeath(Metrics* m, int score);
+
+/* Formats the page into buf; returns its length. */
+int metricsFormat(Metrics* m, char* buf, int size);
+
+#endif
@@ -0,0 +1,112 @@
+#include "perfctr.h"
+#include <string.h>
+#ifdef __linux__
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* counterNames[PERF_COUNTERS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+
+#ifdef __linux__
+
+static const uint64_t counterConfig[PERF_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int openCounter(uint64_t config, int groupFd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = groupFd == -1; // the leader starts the whole group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0);
+}
+
+/* One read() returns every counter in the group: {nr, values[nr]}. */
+static int readGroup(const PerfCounters* p, uint64_t values[PERF_COUNTERS]) {
+    uint64_t buf[1 + PERF_COUNTERS];
+    if (read(p->fd[0], buf, sizeof(buf)) != (ssize_t)sizeof(buf)) return -1;
+    memcpy(values, buf + 1, sizeof(uint64_t) * PERF_COUNTERS);
+    return 0;
+}
+
+int perfOpen(PerfCounters* p, int phaseCount, const char* const* phaseNames) {
+    memset(p, 0, sizeof(*p));
+    p->phaseCount = phaseCount < PERF_MAX_PHASES ? phaseCount : PERF_MAX_PHASES;
+    p->phaseNames = phaseNames;
+    for (int c = 0; c < PERF_COUNTERS; c++) p->fd[c] = -1;
+
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        p->fd[c] = openCounter(counterConfig[c], c == 0 ? -1 : p->fd[0]);
+        if (p->fd[c] < 0) {
+            printf("perf: can't open %s counter: %s (perf_event_paranoid, or no PMU in a VM?)\n", counterNames[c], strerror(errno));
+            perfClose(p);
+            return -1;
+        }
+    }
+    ioctl(p->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(p->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    p->open = 1;
+    return 0;
+}
+
+void perfClose(PerfCounters* p) {
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        if (p->fd[c] >= 0) close(p->fd[c]);
+        p->fd[c] = -1;
+    }
+    p->open = 0;
+}
+
+void perfFrameBegin(PerfCounters* p) {
+    if (!p->open) return;
+    p->frames++;
+    readGroup(p, p->last);
+}
+
+void perfMark(PerfCounters* p, int phase) {
+    if (!p->open || phase < 0 || phase >= p->phaseCount) return;
+    uint64_t now[PERF_COUNTERS];
+    if (readGroup(p, now) != 0) return;
+    for (int c = 0; c < PERF_COUNTERS; c++) {
+        p->totals[phase][c] += now[c] - p->last[c];
+        p->last[c] = now[c];
+    }
+}
+
+#else
+
+int perfOpen(PerfCounters* p, int phaseCount, const char* const* phaseNames) {
+    memset(p, 0, sizeof(*p));
+    (void)phaseCount;
+    (void)phaseNames;
+    printf("perf: hardware counters need Linux perf_event_open\n");
+    return -1;
+}
+
+void perfClose(PerfCounters* p) { p->open = 0; }
+void perfFrameBegin(PerfCounters* p) { (void)p; }
+void perfMark(PerfCounters* p, int phase) { (void)p; (void)phase; }
+
+#endif
+
+void perfPrint(const PerfCounters* p, FILE* out) {
+    if (p->frames == 0) return;
+    // Reads are syscalls: each phase's numbers include part of one read's own cost
+    fprintf(out, "perf: %lu frames, per frame:\n", p->frames);
+    fprintf(out, "%-10s %12s %12s %6s %12s %12s\n", "phase", counterNames[PERF_CYCLES], counterNames[PERF_INSTRUCTIONS], "IPC",
+        counterNames[PERF_CACHE_MISSES], counterNames[PERF_BRANCH_MISSES]);
+    for (int k = 0; k < p->phaseCount; k++) {
+        const uint64_t* t = p->totals[k];
+        double n = (double)p->frames;
+        fprintf(out, "%-10s %12.0f %12.0f %6.2f %12.1f %12.1f\n", p->phaseNames[k], t[PERF_CYCLES] / n, t[PERF_INSTRUCTIONS] / n,
+            t[PERF_CYCLES] ? (double)t[PERF_INSTRUCTIONS] / t[PERF_CYCLES] : 0.0, t[PERF_CACHE_MISSES] / n, t[PERF_BRANCH_MISSES] / n);
+    }
+}
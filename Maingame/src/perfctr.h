@@ -0,0 +1,47 @@
+#ifndef PERFCTR_H
+#define PERFCTR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+   Hardware counters (cycles, instructions, cache misses, branch misses)
+   attributed to loop phases, via Linux perf_event_open. The four counters
+   are one group, so each phase boundary is a single read() of all of them.
+   Elsewhere, or when the kernel refuses (no PMU in a VM,
+   perf_event_paranoid > 2), perfOpen fails and nothing is counted.
+*/
+
+enum {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_CACHE_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTERS
+};
+
+#define PERF_MAX_PHASES 16
+
+typedef struct {
+    int fd[PERF_COUNTERS];
+    int open;
+    int phaseCount;
+    const char* const* phaseNames;
+    uint64_t last[PERF_COUNTERS];
+    uint64_t totals[PERF_MAX_PHASES][PERF_COUNTERS];
+    unsigned long frames;
+} PerfCounters;
+
+/* Opens the counter group for this thread. Returns 0 on success; on failure
+   prints why and leaves p closed, so perfFrameBegin/perfMark do nothing. */
+int perfOpen(PerfCounters* p, int phaseCount, const char* const* phaseNames);
+void perfClose(PerfCounters* p);
+
+void perfFrameBegin(PerfCounters* p);
+/* Charges the counts since the previous mark (or frame start) to phase. */
+void perfMark(PerfCounters* p, int phase);
+
+/* Per phase: cycles and instructions per frame, IPC, and misses per frame. */
+void perfPrint(const PerfCounters* p, FILE* out);
+
+#endif
@@ -0,0 +1,153 @@
+#include "profiler.h"
+#include "log.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_FLUSH_MS 50
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "events", "sim", "spawn", "collision", "audio", "render", "text", "present", "sleep"
+};
+
+const char* profPhaseName(int phase) {
+    return phase >= 0 && phase < PHASE_COUNT ? phaseNames[phase] : "frame";
+}
+
+int profAttachPerf(Profiler* p, PerfCounters* perf) {
+    if (perfOpen(perf, PHASE_COUNT, phaseNames) != 0) return -1;
+    p->perf = perf;
+    return 0;
+}
+
+void profFrameBegin(Profiler* p) {
+    if (p->perf) perfFrameBegin(p->perf);
+    p->frame++;
+    memset(p->frameTicks, 0, sizeof(p->frameTicks));
+    p->mark = SDL_GetPerformanceCounter();
+}
+
+void profMark(Profiler* p, int phase) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    unsigned long head = atomic_load_explicit(&p->head, memory_order_relaxed);
+    ProfSample* s = &p->ring[head & (PROF_RING - 1)];
+    s->start = p->mark;
+    s->end = now;
+    s->frame = p->frame;
+    s->phase = phase;
+    atomic_store_explicit(&p->head, head + 1, memory_order_release); // publish the sample
+    p->frameTicks[phase] += now - p->mark;
+    p->mark = now;
+    if (p->perf) perfMark(p->perf, phase); // its syscall lands in the next phase's time
+}
+
+/* Copies out everything published since the last drain and appends it to
+   the trace as complete ("X") events. Samples the producer lapped are
+   dropped rather than read torn. */
+static void drainTrace(Profiler* p) {
+    ProfSample batch[256];
+    for (;;) {
+        unsigned long head = atomic_load_explicit(&p->head, memory_order_acquire);
+        if (head - p->traceTail > PROF_RING) {
+            p->traceDropped += head - PROF_RING - p->traceTail;
+            p->traceTail = head - PROF_RING;
+        }
+        unsigned long n = head - p->traceTail;
+        if (n == 0) return;
+        if (n > 256) n = 256;
+
+        for (unsigned long k = 0; k < n; k++) batch[k] = p->ring[(p->traceTail + k) & (PROF_RING - 1)];
+        // Slots the producer reached while we copied (including the one it may be writing) are garbage
+        unsigned long after = atomic_load_explicit(&p->head, memory_order_acquire);
+        unsigned long firstValid = after + 1 > PROF_RING ? after + 1 - PROF_RING : 0;
+        unsigned long skip = firstValid > p->traceTail ? firstValid - p->traceTail : 0;
+        if (skip > n) skip = n;
+
+        for (unsigned long k = skip; k < n; k++) {
+            const ProfSample* s = &batch[k];
+            double ts = (s->start - p->origin) * p->msPerTick * 1000.0;
+            double dur = (s->end - s->start) * p->msPerTick * 1000.0;
+            fprintf(p->trace, "%s\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,\"args\":{\"frame\":%u}}",
+                p->traceWritten ? "," : "", phaseNames[s->phase], ts, dur, (unsigned)s->frame);
+            p->traceWritten++;
+        }
+        p->traceDropped += skip;
+        p->traceTail += n;
+    }
+}
+
+static int traceWriter(void* arg) {
+    Profiler* p = arg;
+    while (!atomic_load(&p->stopWriter)) {
+        drainTrace(p);
+        SDL_Delay(TRACE_FLUSH_MS);
+    }
+    drainTrace(p);
+    return 0;
+}
+
+int profInit(Profiler* p, const char* tracePath) {
+    memset(p, 0, sizeof(*p));
+    atomic_init(&p->head, 0);
+    atomic_init(&p->stopWriter, 0);
+    p->msPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+    p->origin = p->mark = SDL_GetPerformanceCounter();
+
+    if (tracePath) {
+        p->trace = fopen(tracePath, "w");
+        if (!p->trace) return -1;
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", p->trace);
+        p->writer = SDL_CreateThread(traceWriter, "trace writer", p);
+        if (!p->writer) { fclose(p->trace); p->trace = NULL; return -1; }
+    }
+    return 0;
+}
+
+void profShutdown(Profiler* p) {
+    if (p->writer) {
+        atomic_store(&p->stopWriter, 1);
+        SDL_WaitThread(p->writer, NULL);
+        p->writer = NULL;
+    }
+    if (p->trace) {
+        fputs("\n]}\n", p->trace);
+        fclose(p->trace);
+        p->trace = NULL;
+        logInfo("trace written", logInt("events", p->traceWritten), logInt("dropped", p->traceDropped));
+    }
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void profStats(const Profiler* p, ProfStats stats[PHASE_COUNT + 1]) {
+    static double totals[PHASE_COUNT + 1][PROF_WINDOW];
+    memset(totals, 0, sizeof(totals));
+    memset(stats, 0, sizeof(ProfStats) * (PHASE_COUNT + 1));
+
+    // The current frame is still in progress; take the PROF_WINDOW before it
+    Uint32 last = p->frame - 1;
+    unsigned long head = atomic_load_explicit(&p->head, memory_order_relaxed);
+    unsigned long oldest = head > PROF_RING ? head - PROF_RING : 0;
+    Uint32 frames = 0;
+    for (unsigned long k = head; k-- > oldest;) {
+        const ProfSample* s = &p->ring[k & (PROF_RING - 1)];
+        if (s->frame > last) continue;
+        Uint32 age = last - s->frame;
+        if (age >= PROF_WINDOW) break;
+        if (age + 1 > frames) frames = age + 1;
+        double ms = (s->end - s->start) * p->msPerTick;
+        totals[s->phase][age] += ms;
+        totals[PHASE_COUNT][age] += ms;
+    }
+    if (frames == 0) return;
+
+    for (int phase = 0; phase <= PHASE_COUNT; phase++) {
+        double sum = 0;
+        for (Uint32 f = 0; f < frames; f++) sum += totals[phase][f];
+        qsort(totals[phase], frames, sizeof(double), compareDoubles);
+        stats[phase].avgMs = sum / frames;
+        stats[phase].p99Ms = totals[phase][(frames - 1) * 99 / 100];
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include "perfctr.h"
+
+/*
+   Per-phase frame timing. The main loop calls profFrameBegin() once per
+   frame and profMark(phase) at the end of each phase; every mark costs one
+   SDL_GetPerformanceCounter read and one ring buffer write. The ring is
+   single-producer: the main thread writes, and the optional trace writer
+   thread drains it into a Chrome/Perfetto trace file without locking.
+*/
+
+enum {
+    PHASE_EVENTS,
+    PHASE_SIM,
+    PHASE_SPAWN,
+    PHASE_COLLISION,
+    PHASE_AUDIO,
+    PHASE_RENDER,
+    PHASE_TEXT,
+    PHASE_PRESENT,
+    PHASE_SLEEP,
+    PHASE_COUNT
+};
+
+#define PROF_RING 8192 // samples, a power of two; about 900 frames
+#define PROF_WINDOW 240 // frames the overlay statistics cover
+
+typedef struct {
+    Uint64 start, end;
+    Uint32 frame;
+    int phase;
+} ProfSample;
+
+typedef struct {
+    double avgMs, p99Ms;
+} ProfStats;
+
+typedef struct {
+    ProfSample ring[PROF_RING];
+    atomic_ulong head; // samples ever written
+    Uint64 mark, origin;
+    double msPerTick;
+    Uint32 frame;
+    Uint64 frameTicks[PHASE_COUNT]; // this frame's per-phase totals so far
+    PerfCounters* perf; // optional hardware counters read at the same marks
+
+    FILE* trace;
+    unsigned long traceTail, traceWritten, traceDropped;
+    SDL_Thread* writer;
+    atomic_int stopWriter;
+} Profiler;
+
+/* Starts the writer thread when tracePath is set. Returns 0 on success; on
+   failure the profiler still works, just without a trace. The struct is
+   large (the ring is inline), so keep it static. */
+int profInit(Profiler* p, const char* tracePath);
+/* Stops the writer and finishes the trace file. */
+void profShutdown(Profiler* p);
+
+/* Opens hardware counters and reads them at every phase boundary from now
+   on (--perf). Returns 0 on success. */
+int profAttachPerf(Profiler* p, PerfCounters* perf);
+
+void profFrameBegin(Profiler* p);
+/* Records the time since the previous mark (or frame start) as phase. */
+void profMark(Profiler* p, int phase);
+
+/* Average and p99 of each phase's per-frame total over the last PROF_WINDOW
+   finished frames, plus the whole frame in stats[PHASE_COUNT]. Main thread only. */
+void profStats(const Profiler* p, ProfStats stats[PHASE_COUNT + 1]);
+const char* profPhaseName(int phase);
+
+#endif
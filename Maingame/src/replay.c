@@ -0,0 +1,140 @@
+#include "replay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char replayMagic[4] = {'F', 'B', 'R', '1'};
+
+static void putByte(Replay* r, unsigned char b) {
+    if (r->size == r->capacity) {
+        size_t cap = r->capacity ? r->capacity * 2 : 256;
+        unsigned char* data = realloc(r->data, cap);
+        if (!data) return; // out of memory: the recording is truncated, the game goes on
+        r->data = data;
+        r->capacity = cap;
+    }
+    r->data[r->size++] = b;
+}
+
+static void putVarint(Replay* r, uint64_t v) {
+    while (v >= 0x80) {
+        putByte(r, (unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    putByte(r, (unsigned char)v);
+}
+
+/* Decodes a varint at *pos; returns 0 at the end of the buffer. */
+static int getVarint(const unsigned char* data, size_t size, size_t* pos, uint64_t* v) {
+    *v = 0;
+    for (int shift = 0; *pos < size && shift < 64; shift += 7) {
+        unsigned char b = data[(*pos)++];
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return 1;
+    }
+    return 0;
+}
+
+void replayBegin(Replay* r, uint64_t seed) {
+    memset(r, 0, sizeof(*r));
+    r->seed = seed;
+}
+
+int replayReserve(Replay* r, size_t bytes) {
+    if (bytes <= r->capacity) return 0;
+    unsigned char* data = realloc(r->data, bytes);
+    if (!data) return -1;
+    r->data = data;
+    r->capacity = bytes;
+    return 0;
+}
+
+void replayFree(Replay* r) {
+    free(r->data);
+    memset(r, 0, sizeof(*r));
+}
+
+int replaySave(const Replay* r, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    Replay header;
+    replayBegin(&header, 0);
+    putVarint(&header, r->seed);
+    int ok = fwrite(replayMagic, 1, 4, f) == 4 &&
+             fwrite(header.data, 1, header.size, f) == header.size &&
+             fwrite(r->data, 1, r->size, f) == r->size;
+    replayFree(&header);
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+int replayLoad(Replay* r, const char* path) {
+    replayBegin(r, 0);
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    char magic[4];
+    if (fread(magic, 1, 4, f) != 4 || memcmp(magic, replayMagic, 4) != 0) { fclose(f); return -1; }
+
+    unsigned char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        for (size_t i = 0; i < n; i++) putByte(r, buf[i]);
+    fclose(f);
+
+    if (!getVarint(r->data, r->size, &r->readPos, &r->seed)) { replayFree(r); return -1; }
+    return 0;
+}
+
+static void recordEvent(Replay* r, unsigned long tick, int kind) {
+    putVarint(r, ((uint64_t)(tick - r->lastTick) << 2) | (uint64_t)kind);
+    r->lastTick = tick;
+}
+
+void replayRecordInput(Replay* r, const GameState* g, GameInput input) {
+    if (input.flap) recordEvent(r, g->frame, REPLAY_FLAP);
+    if (input.dash != r->dash) recordEvent(r, g->frame, input.dash ? REPLAY_DASH_DOWN : REPLAY_DASH_UP);
+    r->dash = input.dash;
+}
+
+void replayEndGame(Replay* r, const GameState* g) {
+    recordEvent(r, g->frame, REPLAY_END);
+    putVarint(r, (uint64_t)g->score);
+    r->lastTick = 0;
+    r->dash = 0;
+}
+
+int replayInput(Replay* r, const GameState* g, GameInput* input) {
+    input->flap = 0;
+    for (;;) {
+        size_t pos = r->readPos;
+        uint64_t v;
+        if (!getVarint(r->data, r->size, &pos, &v)) { input->dash = r->dash; return REPLAY_FINISHED; }
+
+        unsigned long tick = r->lastTick + (unsigned long)(v >> 2);
+        int kind = (int)(v & 3);
+        if (tick > g->frame) break;
+
+        r->readPos = pos;
+        r->lastTick = tick;
+        if (kind == REPLAY_END) {
+            uint64_t score = 0;
+            getVarint(r->data, r->size, &r->readPos, &score);
+            r->endScore = (int)score;
+            r->lastTick = 0;
+            r->dash = 0;
+            return REPLAY_GAME_OVER;
+        }
+        if (kind == REPLAY_FLAP) input->flap = 1;
+        else r->dash = kind == REPLAY_DASH_DOWN;
+    }
+    input->dash = r->dash;
+    return REPLAY_STEP;
+}
+
+void replaySkipGame(Replay* r) {
+    GameState end;
+    end.frame = (unsigned long)-1;
+    GameInput unused;
+    while (replayInput(r, &end, &unused) == REPLAY_STEP) {}
+}
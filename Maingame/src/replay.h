@@ -0,0 +1,56 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stddef.h>
+#include "game.h"
+
+/*
+   Session recording: the session seed plus every input change, indexed by
+   simulation tick. Game n of the session plays seed + n.
+
+   File layout: "FBR1", varint seed, then one varint per event holding
+   (ticks since the previous event of the same game << 2) | kind. A
+   REPLAY_END event closes each game at its final tick and is followed by a
+   varint with the final score, for checking playback. Varints are LEB128.
+*/
+
+enum {
+    REPLAY_FLAP,
+    REPLAY_DASH_DOWN,
+    REPLAY_DASH_UP,
+    REPLAY_END
+};
+
+typedef struct {
+    unsigned char* data;
+    size_t size, capacity;
+    uint64_t seed;
+    unsigned long lastTick; // tick of the previous event in the current game
+    size_t readPos;
+    int dash; // dash state as last recorded / replayed
+    int endScore; // playback: score recorded with the last REPLAY_END
+} Replay;
+
+/* Result of replayInput */
+#define REPLAY_STEP 0      // step the game with the returned input
+#define REPLAY_GAME_OVER 1 // the recorded game ended at this tick
+#define REPLAY_FINISHED 2  // no more events
+
+void replayBegin(Replay* r, uint64_t seed);
+/* Sizes the buffer up front so recording doesn't allocate mid-game. */
+int replayReserve(Replay* r, size_t bytes);
+void replayFree(Replay* r);
+int replaySave(const Replay* r, const char* path);
+int replayLoad(Replay* r, const char* path);
+
+/* Recording: call before each gameStep with the input about to be used,
+   and replayEndGame once the game is over (or abandoned). */
+void replayRecordInput(Replay* r, const GameState* g, GameInput input);
+void replayEndGame(Replay* r, const GameState* g);
+
+/* Playback: input for the next gameStep of g. */
+int replayInput(Replay* r, const GameState* g, GameInput* input);
+/* Playback: drops the rest of the current game, e.g. after it desynced. */
+void replaySkipGame(Replay* r);
+
+#endif
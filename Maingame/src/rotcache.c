@@ -0,0 +1,117 @@
+#include "rotcache.h"
+#include "log.h"
+#include "cpublit.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ROT_TEXTURE_WIDTH 2048
+
+static int rotIndex(int sprite) {
+    if (sprite == SPRITE_BIRD) return ROT_BIRD;
+    if (sprite == SPRITE_BIRD_DASH) return ROT_BIRD_DASH;
+    return -1;
+}
+
+static const int rotSprites[ROT_SPRITES] = {SPRITE_BIRD, SPRITE_BIRD_DASH};
+
+int rotCacheInit(RotCache* c, SDL_Renderer* renderer, const Atlas* a) {
+    memset(c, 0, sizeof(*c));
+    if (!a->pixels || !a->loaded[SPRITE_BIRD]) return -1;
+    c->spriteW = a->regions[SPRITE_BIRD].w;
+    c->spriteH = a->regions[SPRITE_BIRD].h;
+
+    // Widest and tallest bounding box over the angle range
+    for (int i = 0; i < ROT_STEPS; i++) {
+        double rad = (ROT_MIN_ANGLE + i) * M_PI / 180.0;
+        double cs = SDL_fabs(SDL_cos(rad)), sn = SDL_fabs(SDL_sin(rad));
+        int w = (int)SDL_ceil(c->spriteW * cs + c->spriteH * sn);
+        int h = (int)SDL_ceil(c->spriteW * sn + c->spriteH * cs);
+        if (w > c->cellW) c->cellW = w;
+        if (h > c->cellH) c->cellH = h;
+    }
+    c->cellW += 2; // a transparent border so bilinear filtering at the edges stays clean
+    c->cellH += 2;
+    c->columns = ROT_TEXTURE_WIDTH / c->cellW;
+    c->rows = (ROT_SPRITES * ROT_STEPS + c->columns - 1) / c->columns;
+
+    for (int s = 0; s < ROT_SPRITES; s++) {
+        const SDL_Rect* r = &a->regions[rotSprites[s]];
+        if (!a->loaded[rotSprites[s]] || r->w != c->spriteW || r->h != c->spriteH) continue;
+        c->source[s] = malloc(sizeof(Uint32) * c->spriteW * c->spriteH);
+        if (!c->source[s]) continue;
+        for (int y = 0; y < c->spriteH; y++)
+            memcpy(c->source[s] + y * c->spriteW, (const Uint8*)a->pixels->pixels + (r->y + y) * a->pixels->pitch + 4 * r->x,
+                sizeof(Uint32) * c->spriteW);
+    }
+    c->scratch = malloc(sizeof(Uint32) * c->cellW * c->cellH);
+    if (c->scratch && renderer) c->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_STATIC, c->columns * c->cellW, c->rows * c->cellH);
+    else if (c->scratch) c->pixels = calloc((size_t)c->columns * c->cellW * c->rows * c->cellH, sizeof(Uint32));
+    if (!c->texture && !c->pixels) {
+        logWarn("can't create rotation cache, rotating sprites as quads", logStr("error", SDL_GetError()));
+        rotCacheFree(c);
+        return -1;
+    }
+    if (c->texture) SDL_SetTextureBlendMode(c->texture, SDL_BLENDMODE_BLEND);
+    return 0;
+}
+
+void rotCacheFree(RotCache* c) {
+    if (c->texture) SDL_DestroyTexture(c->texture);
+    for (int s = 0; s < ROT_SPRITES; s++) free(c->source[s]);
+    free(c->scratch);
+    free(c->pixels);
+    memset(c, 0, sizeof(*c));
+}
+
+/* Rotates source into scratch, centred, sampling bilinearly. Colour is
+   interpolated premultiplied so the transparent border doesn't darken edges. */
+static void rotateSprite(RotCache* c, const Uint32* source, int degrees) {
+    float rad = degrees * (float)M_PI / 180.0f;
+    float cs = SDL_cosf(rad), sn = SDL_sinf(rad);
+    float halfW = c->spriteW * 0.5f, halfH = c->spriteH * 0.5f;
+    Uint8* out = (Uint8*)c->scratch;
+    for (int y = 0; y < c->cellH; y++) {
+        float py = y + 0.5f - c->cellH * 0.5f;
+        for (int x = 0; x < c->cellW; x++, out += 4) {
+            // Inverse rotation back into the sprite, in texel-centre coordinates
+            float px = x + 0.5f - c->cellW * 0.5f;
+            float u = px * cs + py * sn + halfW - 0.5f;
+            float v = -px * sn + py * cs + halfH - 0.5f;
+            int x0 = (int)SDL_floorf(u), y0 = (int)SDL_floorf(v);
+            float fx = u - x0, fy = v - y0;
+            float acc[4] = {0, 0, 0, 0};
+            for (int k = 0; k < 4; k++) {
+                int sx = x0 + (k & 1), sy = y0 + (k >> 1);
+                if (sx < 0 || sy < 0 || sx >= c->spriteW || sy >= c->spriteH) continue;
+                float w = ((k & 1) ? fx : 1.0f - fx) * ((k >> 1) ? fy : 1.0f - fy);
+                const Uint8* p = (const Uint8*)&source[sy * c->spriteW + sx];
+                float wa = w * p[3];
+                acc[0] += p[0] * wa; acc[1] += p[1] * wa; acc[2] += p[2] * wa; acc[3] += wa;
+            }
+            for (int i = 0; i < 3; i++) out[i] = acc[3] > 0 ? (Uint8)SDL_min(acc[i] / acc[3] + 0.5f, 255.0f) : 0;
+            out[3] = (Uint8)SDL_min(acc[3] + 0.5f, 255.0f);
+        }
+    }
+}
+
+int rotCacheGet(RotCache* c, int sprite, float angle, SDL_Rect* cell) {
+    int s = rotIndex(sprite);
+    if ((!c->texture && !c->pixels) || s < 0 || !c->source[s]) return -1;
+    int step = (int)SDL_lroundf(angle) - ROT_MIN_ANGLE;
+    if (step < 0) step = 0;
+    if (step >= ROT_STEPS) step = ROT_STEPS - 1;
+
+    int n = s * ROT_STEPS + step;
+    *cell = (SDL_Rect){(n % c->columns) * c->cellW, (n / c->columns) * c->cellH, c->cellW, c->cellH};
+    if (!c->built[s][step]) {
+        rotateSprite(c, c->source[s], ROT_MIN_ANGLE + step);
+        if (c->pixels) {
+            for (int y = 0; y < cell->h; y++)
+                blitPremultiply(c->pixels + (cell->y + y) * c->columns * c->cellW + cell->x, (const Uint8*)(c->scratch + y * c->cellW), c->cellW);
+        } else if (SDL_UpdateTexture(c->texture, cell, c->scratch, c->cellW * 4) != 0) {
+            return -1;
+        }
+        c->built[s][step] = 1;
+    }
+    return 0;
+}
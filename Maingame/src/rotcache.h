@@ -0,0 +1,48 @@
+#ifndef ROTCACHE_H
+#define ROTCACHE_H
+
+#include <SDL2/SDL.h>
+#include "atlas.h"
+
+/*
+   The bird and dash sprites pre-rotated in whole degrees across the bird's
+   -45..45 range, so a renderer where a rotated quad is far slower than a
+   plain copy (SDL's software renderer) only ever copies. Each frame is
+   rotated on the CPU at the sprite's drawn size the first time its angle is
+   asked for and uploaded into its cell of one texture. GPU renderers rotate
+   natively and leave the cache off. Created without a renderer, the cells
+   are kept in memory instead, premultiplied, for the CPU renderer.
+*/
+
+#define ROT_MIN_ANGLE (-45)
+#define ROT_STEPS 91 // 1 degree apart
+
+enum {
+    ROT_BIRD,
+    ROT_BIRD_DASH,
+    ROT_SPRITES
+};
+
+typedef struct {
+    SDL_Texture* texture; // NULL when the cache is off or on the CPU
+    Uint32* pixels; // CPU cells, premultiplied ARGB8888, pitch columns * cellW
+    int cellW, cellH; // fits the sprite at any angle in range
+    int columns, rows;
+    int spriteW, spriteH;
+    Uint32* source[ROT_SPRITES]; // RGBA32 at drawn size; NULL if the sprite didn't load
+    Uint32* scratch; // one cell
+    unsigned char built[ROT_SPRITES][ROT_STEPS];
+} RotCache;
+
+/* Copies the bird sprites out of a->pixels (atlasLoad with ATLAS_KEEP_PIXELS)
+   and creates the cell texture, or CPU cells when renderer is NULL. Returns 0
+   on success; on failure the cache stays off and sprites are rotated as quads. */
+int rotCacheInit(RotCache* c, SDL_Renderer* renderer, const Atlas* a);
+void rotCacheFree(RotCache* c);
+
+/* The texture cell holding sprite (SPRITE_BIRD or SPRITE_BIRD_DASH) rotated
+   clockwise by angle rounded to a whole degree, rendering it on first use.
+   Returns 0 and fills cell, or -1 if the cache can't serve it. */
+int rotCacheGet(RotCache* c, int sprite, float angle, SDL_Rect* cell);
+
+#endif
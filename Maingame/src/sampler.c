@@ -0,0 +1,226 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // dladdr, REG_RIP, pthread_getattr_np
+#endif
+#include "sampler.h"
+#include <stdio.h>
+#include <string.h>
+
+const char* samplerPathArg(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") != 0) continue;
+        if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) return argv[i + 1];
+        return "profile.folded";
+    }
+    return NULL;
+}
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+
+#include <dlfcn.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <ucontext.h>
+
+typedef struct {
+    uint64_t hash; // 0 = empty
+    unsigned long count;
+    int depth;
+    int mainThread;
+    uintptr_t pcs[SAMPLER_DEPTH]; // leaf first
+} StackEntry;
+
+static StackEntry* stacks;
+static atomic_flag tableLock = ATOMIC_FLAG_INIT;
+static atomic_ulong samples, dropped;
+static uintptr_t mainStackLo, mainStackHi;
+static timer_t timer;
+static int running;
+
+static uint64_t hashStack(const uintptr_t* pcs, int depth, int mainThread) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ (uint64_t)mainThread;
+    for (int i = 0; i < depth; i++) h = (h ^ pcs[i]) * 0x100000001b3ULL;
+    return h ? h : 1;
+}
+
+/* Follows saved frame pointers, but only within the main thread's stack,
+   whose bounds we know: anything else could fault. */
+static int walkFrames(uintptr_t pc, uintptr_t fp, uintptr_t* pcs) {
+    int depth = 0;
+    pcs[depth++] = pc;
+    while (depth < SAMPLER_DEPTH && fp >= mainStackLo && fp + 2 * sizeof(uintptr_t) <= mainStackHi && (fp & (sizeof(uintptr_t) - 1)) == 0) {
+        const uintptr_t* frame = (const uintptr_t*)fp;
+        uintptr_t next = frame[0], ret = frame[1];
+        if (ret == 0) break;
+        pcs[depth++] = ret;
+        if (next <= fp) break; // stacks grow down, so callers' frames are higher
+        fp = next;
+    }
+    return depth;
+}
+
+static void onSample(int sig, siginfo_t* info, void* context) {
+    (void)sig;
+    (void)info;
+    const ucontext_t* uc = context;
+#if defined(__x86_64__)
+    uintptr_t pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP], fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.gregs[REG_RSP];
+#else
+    uintptr_t pc = (uintptr_t)uc->uc_mcontext.pc, fp = (uintptr_t)uc->uc_mcontext.regs[29];
+    uintptr_t sp = (uintptr_t)uc->uc_mcontext.sp;
+#endif
+    int mainThread = sp >= mainStackLo && sp < mainStackHi;
+    uintptr_t pcs[SAMPLER_DEPTH];
+    int depth = mainThread ? walkFrames(pc, fp, pcs) : (pcs[0] = pc, 1);
+    uint64_t h = hashStack(pcs, depth, mainThread);
+    atomic_fetch_add_explicit(&samples, 1, memory_order_relaxed);
+
+    // Another thread is inside the table: drop rather than spin in a signal handler
+    if (atomic_flag_test_and_set_explicit(&tableLock, memory_order_acquire)) {
+        atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+        return;
+    }
+    for (unsigned int probe = 0; probe < SAMPLER_STACKS; probe++) {
+        StackEntry* e = &stacks[(h + probe) & (SAMPLER_STACKS - 1)];
+        if (e->hash == 0) {
+            e->hash = h;
+            e->count = 1;
+            e->depth = depth;
+            e->mainThread = mainThread;
+            memcpy(e->pcs, pcs, depth * sizeof(uintptr_t));
+            atomic_flag_clear_explicit(&tableLock, memory_order_release);
+            return;
+        }
+        if (e->hash == h && e->depth == depth && e->mainThread == mainThread && memcmp(e->pcs, pcs, depth * sizeof(uintptr_t)) == 0) {
+            e->count++;
+            atomic_flag_clear_explicit(&tableLock, memory_order_release);
+            return;
+        }
+        if (probe > 64) break; // table is getting full; don't make the handler slow
+    }
+    atomic_flag_clear_explicit(&tableLock, memory_order_release);
+    atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+}
+
+int samplerStart(int hz) {
+    if (hz <= 0) hz = SAMPLER_DEFAULT_HZ;
+    stacks = calloc(SAMPLER_STACKS, sizeof(StackEntry));
+    if (!stacks) return -1;
+    atomic_flag_clear(&tableLock); // a previous samplerStop leaves it held
+
+    pthread_attr_t attr;
+    void* stackAddr;
+    size_t stackSize;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        if (pthread_attr_getstack(&attr, &stackAddr, &stackSize) == 0) {
+            mainStackLo = (uintptr_t)stackAddr;
+            mainStackHi = mainStackLo + stackSize;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = onSample;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = SIGPROF;
+    if (sigaction(SIGPROF, &sa, NULL) != 0 || timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &timer) != 0) {
+        printf("profile: can't arm SIGPROF timer\n");
+        free(stacks);
+        stacks = NULL;
+        return -1;
+    }
+
+    long ns = 1000000000L / hz;
+    struct itimerspec its = {{ns / 1000000000L, ns % 1000000000L}, {ns / 1000000000L, ns % 1000000000L}};
+    timer_settime(timer, 0, &its, NULL);
+    running = 1;
+    return 0;
+}
+
+/* Appends "name" for pc to line; return addresses point after the call, so look up pc - 1. */
+static size_t appendFrame(char* line, size_t len, size_t cap, uintptr_t pc, int isReturn) {
+    Dl_info dl;
+    uintptr_t lookup = isReturn ? pc - 1 : pc;
+    int found = dladdr((void*)lookup, &dl) != 0;
+    if (found && dl.dli_sname) return len + snprintf(line + len, cap - len, ";%s", dl.dli_sname);
+    if (found && dl.dli_fname) {
+        const char* base = strrchr(dl.dli_fname, '/');
+        return len + snprintf(line + len, cap - len, ";%s+0x%lx", base ? base + 1 : dl.dli_fname,
+            (unsigned long)(lookup - (uintptr_t)dl.dli_fbase));
+    }
+    return len + snprintf(line + len, cap - len, ";0x%lx", (unsigned long)lookup);
+}
+
+typedef struct {
+    char* line;
+    unsigned long count;
+} Folded;
+
+static int compareFolded(const void* a, const void* b) {
+    return strcmp(((const Folded*)a)->line, ((const Folded*)b)->line);
+}
+
+void samplerStop(const char* path) {
+    if (!running) return;
+    timer_delete(timer);
+    signal(SIGPROF, SIG_IGN);
+    running = 0;
+    // Wait out a handler still running on another thread; later ones see the lock and drop
+    while (atomic_flag_test_and_set_explicit(&tableLock, memory_order_acquire)) {}
+
+    // Symbolize every stack; different pcs in the same functions give the same line, so sort and merge
+    Folded* folded = calloc(SAMPLER_STACKS, sizeof(Folded));
+    int count = 0;
+    char line[SAMPLER_DEPTH * 160];
+    for (int i = 0; folded && i < SAMPLER_STACKS; i++) {
+        const StackEntry* e = &stacks[i];
+        if (e->hash == 0) continue;
+        size_t len = snprintf(line, sizeof(line), "%s", e->mainThread ? "main-thread" : "other-threads");
+        for (int d = e->depth - 1; d >= 0 && len < sizeof(line); d--) len = appendFrame(line, len, sizeof(line), e->pcs[d], d > 0);
+        folded[count].line = strdup(line);
+        folded[count].count = e->count;
+        if (folded[count].line) count++;
+    }
+    free(stacks);
+    stacks = NULL;
+    if (!folded) return;
+    qsort(folded, count, sizeof(Folded), compareFolded);
+
+    FILE* f = fopen(path, "w");
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        if (i + 1 < count && strcmp(folded[i].line, folded[i + 1].line) == 0) {
+            folded[i + 1].count += folded[i].count;
+        } else if (f) {
+            fprintf(f, "%s %lu\n", folded[i].line, folded[i].count);
+            written++;
+        }
+        free(folded[i].line);
+    }
+    free(folded);
+    if (!f) { printf("profile: can't write %s\n", path); return; }
+    fclose(f);
+    printf("profile: %lu samples, %d stacks, %lu dropped, written to %s\n",
+        (unsigned long)atomic_load(&samples), written, (unsigned long)atomic_load(&dropped), path);
+}
+
+#else
+
+int samplerStart(int hz) {
+    (void)hz;
+    printf("profile: the sampling profiler needs Linux on x86-64 or arm64\n");
+    return -1;
+}
+
+void samplerStop(const char* path) { (void)path; }
+
+#endif
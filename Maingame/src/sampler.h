@@ -0,0 +1,31 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+/*
+   In-process sampling profiler for long soak runs (Linux). A CPU-time
+   interval timer raises SIGPROF; the handler takes the interrupted
+   instruction pointer plus a shallow frame-pointer backtrace and counts it
+   in a preallocated table of unique stacks, so memory stays flat for hours.
+   At exit the stacks are symbolized with dladdr and written as folded
+   stacks ("root;...;leaf count") for flamegraph.pl or speedscope.
+
+   Stacks are rooted at main-thread or other-threads; only the main thread's
+   stack bounds are known, so other threads get the sampled function alone.
+   Build with -fno-omit-frame-pointer for deep stacks and -rdynamic so
+   dladdr can name functions; static functions show up as module+offset.
+*/
+
+#define SAMPLER_DEFAULT_HZ 997 // just off 1 kHz so it doesn't beat against the frame rate
+#define SAMPLER_DEPTH 24
+#define SAMPLER_STACKS 16384 // unique stacks kept; further new ones are counted as dropped
+
+/* Arms the timer. Returns 0 on success, -1 (with a message) where unsupported. */
+int samplerStart(int hz);
+/* Disarms the timer, writes the folded stacks to path and frees the table. */
+void samplerStop(const char* path);
+
+/* Finds --profile [FILE] in argv. Returns the output path, "profile.folded"
+   when no file is given, or NULL when the flag is absent. */
+const char* samplerPathArg(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,109 @@
+#include "scene.h"
+
+const SDL_Rect sceneStartButton = {WINDOW_WIDTH/2 - 400, WINDOW_HEIGHT/2 - 100, 800, 200};
+const SDL_Rect sceneRestartButton = {WINDOW_WIDTH/2 - 150, WINDOW_HEIGHT/2 - 50, 300, 100};
+
+static const char creditLabel[] = "Assets made by Wish Techawashira";
+static const char scoreLabel[] = "Score: ";
+
+static float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+static float birdAngle(float birdVelocity) {
+    float angle = -birdVelocity * 3.0f;
+    if (angle > 45.0f) angle = 45.0f;
+    if (angle < -45.0f) angle = -45.0f;
+    return angle;
+}
+
+void sceneDrawSprites(RenderBackend* b, int inMenu, const GameState* game, const GameState* prev, float alpha) {
+    SDL_Rect screen = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+    b->sprite(b, SPRITE_BG, &screen, 0);
+
+    if (inMenu) {
+        b->sprite(b, SPRITE_START, &sceneStartButton, 0);
+        return;
+    }
+
+    // Draw pipes
+    for (int k = 0; k < game->pipeCount; k++) {
+        unsigned int n = game->pipeHead + k;
+        const Pipe* p = gamePipeConst(game, n);
+        // Only interpolate pipes that were already alive last tick
+        int x = p->x;
+        if (n - prev->pipeHead < (unsigned int)prev->pipeCount)
+            x = (int)lerp((float)gamePipeConst(prev, n)->x, (float)p->x, alpha);
+        SDL_Rect top = {x, 0, PIPE_WIDTH, p->height};
+        SDL_Rect bottom = {x, p->height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - p->height - PIPE_GAP};
+        b->sprite(b, SPRITE_PIPE_TOP, &top, 0);
+        b->sprite(b, SPRITE_PIPE_BOTTOM, &bottom, 0);
+    }
+
+    float angle = lerp(birdAngle(prev->birdVelocity), birdAngle(game->birdVelocity), alpha);
+    int dash = game->dashing && (!b->atlas || b->atlas->loaded[SPRITE_BIRD_DASH]);
+    SDL_Rect birdRect = {game->birdRect.x, (int)lerp(prev->birdY, game->birdY, alpha), game->birdRect.w, game->birdRect.h};
+    b->sprite(b, dash ? SPRITE_BIRD_DASH : SPRITE_BIRD, &birdRect, angle);
+
+    // Restart button if game over
+    if (game->gameOver) b->sprite(b, SPRITE_RESTART, &sceneRestartButton, 0);
+}
+
+void sceneDrawText(RenderBackend* b, int inMenu, const GameState* game) {
+    int w, h;
+    if (inMenu) {
+        // Tips bottom-right
+        b->textSize(b, creditLabel, -1, &w, &h);
+        b->text(b, creditLabel, -1, 20, WINDOW_HEIGHT - h - 20);
+        return;
+    }
+
+    // Draw score: cached label plus prerendered digits, centred together
+    b->textSize(b, scoreLabel, game->score, &w, &h);
+    b->text(b, scoreLabel, game->score, WINDOW_WIDTH/2 - w/2, 20);
+}
+
+void sceneWarmText(RenderBackend* b) {
+    int w, h;
+    b->textSize(b, creditLabel, -1, &w, &h);
+    b->textSize(b, scoreLabel, 0, &w, &h);
+}
+
+void sceneLayerInit(SceneLayer* l, SDL_Renderer* renderer) {
+    SDL_memset(l, 0, sizeof(*l));
+    if (!SDL_RenderTargetSupported(renderer)) return;
+    l->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, WINDOW_WIDTH, WINDOW_HEIGHT);
+    if (l->texture) SDL_SetTextureBlendMode(l->texture, SDL_BLENDMODE_NONE); // opaque: replaces the whole frame
+}
+
+void sceneLayerFree(SceneLayer* l) {
+    if (l->texture) SDL_DestroyTexture(l->texture);
+    SDL_memset(l, 0, sizeof(*l));
+}
+
+void sceneLayerInvalidate(SceneLayer* l) {
+    l->valid = 0;
+}
+
+void sceneDrawStatic(RenderBackend* b, SceneLayer* l, int inMenu, const GameState* game) {
+    // A finished game is drawn where it stopped, without interpolation
+    if (!l->texture || b->kind != BACKEND_SDL) {
+        sceneDrawSprites(b, inMenu, game, game, 1.0f);
+        sceneDrawText(b, inMenu, game);
+        return;
+    }
+    int current = l->valid && l->inMenu == inMenu && (inMenu || (l->seed == game->seed && l->frame == game->frame));
+    if (!current) {
+        SDL_SetRenderTarget(b->renderer, l->texture);
+        SDL_RenderClear(b->renderer);
+        sceneDrawSprites(b, inMenu, game, game, 1.0f);
+        sceneDrawText(b, inMenu, game);
+        b->flush(b);
+        SDL_SetRenderTarget(b->renderer, NULL);
+        l->valid = 1;
+        l->inMenu = inMenu;
+        l->seed = game->seed;
+        l->frame = game->frame;
+    }
+    SDL_RenderCopy(b->renderer, l->texture, NULL, NULL);
+}
@@ -0,0 +1,49 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include "game.h"
+#include "backend.h"
+
+/*
+   Draws the menu or a game frame from a GameState through a RenderBackend,
+   so the game loop and the benchmarks render exactly the same thing on any
+   backend. Text is drawn on top of the sprites by sceneDrawText. Both go
+   between the backend's begin and flush.
+*/
+
+/*
+   The menu and the game-over screen don't move, so they are composed once
+   into a window-sized render target and copied out whole while they last.
+   Only the SDL backend has one; without render target support texture stays
+   NULL and they draw directly.
+*/
+typedef struct {
+    SDL_Texture* texture;
+    int valid;
+    int inMenu; // what's in it: the menu, or the game that ended at seed/frame
+    uint64_t seed;
+    unsigned long frame;
+} SceneLayer;
+
+extern const SDL_Rect sceneStartButton, sceneRestartButton;
+
+/* Background plus the menu, or pipes, bird and restart button interpolated
+   alpha of the way from prev to game. */
+void sceneDrawSprites(RenderBackend* b, int inMenu, const GameState* game, const GameState* prev, float alpha);
+/* The menu credit, or the score. */
+void sceneDrawText(RenderBackend* b, int inMenu, const GameState* game);
+/* Rasterizes the labels sceneDrawText uses into the backend's text cache, so
+   the first frame of play doesn't touch TTF or the heap. */
+void sceneWarmText(RenderBackend* b);
+
+void sceneLayerInit(SceneLayer* l, SDL_Renderer* renderer);
+void sceneLayerFree(SceneLayer* l);
+/* Forgets the contents, e.g. after SDL_RENDER_TARGETS_RESET. */
+void sceneLayerInvalidate(SceneLayer* l);
+/* Draws the menu or the finished game from l, composing it first if it
+   holds something else. Sprites and text both. */
+void sceneDrawStatic(RenderBackend* b, SceneLayer* l, int inMenu, const GameState* game);
+
+#endif
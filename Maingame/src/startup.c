@@ -0,0 +1,86 @@
+#include "startup.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BAR_WIDTH 40
+
+void startupBegin(StartupTimeline* t) {
+    memset(t, 0, sizeof(*t));
+    t->origin = t->mark = SDL_GetPerformanceCounter();
+}
+
+void startupMark(StartupTimeline* t, const char* name) {
+    if (!t) return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (t->count < STARTUP_MAX_STEPS) {
+        StartupStep* s = &t->steps[t->count++];
+        snprintf(s->name, sizeof(s->name), "%s", name);
+        s->start = t->mark;
+        s->end = now;
+    }
+    t->mark = now;
+}
+
+static double ticksToMs(Uint64 ticks) {
+    return ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+double startupElapsedMs(const StartupTimeline* t) {
+    return ticksToMs(t->mark - t->origin);
+}
+
+void startupPrint(const StartupTimeline* t, FILE* out) {
+    double total = startupElapsedMs(t);
+    fprintf(out, "startup timeline (%.1f ms):\n%9s %9s  %s\n", total, "at ms", "took ms", "step");
+    for (int i = 0; i < t->count; i++) {
+        const StartupStep* s = &t->steps[i];
+        double at = ticksToMs(s->start - t->origin), took = ticksToMs(s->end - s->start);
+        // Gantt-style bar: where in the total the step ran
+        char bar[BAR_WIDTH + 1];
+        int from = total > 0 ? (int)(at / total * BAR_WIDTH) : 0;
+        int to = total > 0 ? (int)((at + took) / total * BAR_WIDTH + 0.5) : 0;
+        if (to <= from) to = from + 1;
+        if (to > BAR_WIDTH) to = BAR_WIDTH;
+        for (int k = 0; k < BAR_WIDTH; k++) bar[k] = k >= from && k < to ? '#' : '.';
+        bar[BAR_WIDTH] = '\0';
+        fprintf(out, "%9.2f %9.2f  %-*s %s\n", at, took, STARTUP_NAME_LEN - 1, s->name, bar);
+    }
+}
+
+static double wallMs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static int compareDoubles(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+int startupBench(const char* exe, int runs) {
+    if (runs < 1) runs = 1;
+    double* times = malloc(sizeof(double) * runs);
+    if (!times) return 1;
+
+    // Children inherit the environment: no window, no sound device
+    SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    char command[1024];
+    snprintf(command, sizeof(command), "\"%s\" --exit-after-first-frame", exe);
+
+    int failed = 0;
+    for (int i = 0; i < runs; i++) {
+        double start = wallMs();
+        int status = system(command);
+        times[i] = wallMs() - start;
+        if (status != 0) { printf("startup bench: run %d failed (status %d)\n", i, status); failed++; }
+    }
+
+    qsort(times, runs, sizeof(double), compareDoubles);
+    printf("startup bench: %d launches to first frame (dummy drivers), median %.1f ms, p95 %.1f ms, min %.1f ms, max %.1f ms\n",
+        runs, times[runs / 2], times[(runs - 1) * 95 / 100], times[0], times[runs - 1]);
+    free(times);
+    return failed ? 1 : 0;
+}
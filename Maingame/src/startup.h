@@ -0,0 +1,39 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+/*
+   Wall-clock timeline of startup, one entry per step from the top of main
+   to the first presented frame. Printed with --startup-report;
+   --startup-bench N relaunches the game N times under SDL's dummy drivers
+   and reports time to first frame.
+*/
+
+#define STARTUP_MAX_STEPS 32
+#define STARTUP_NAME_LEN 40
+
+typedef struct {
+    char name[STARTUP_NAME_LEN];
+    Uint64 start, end;
+} StartupStep;
+
+typedef struct {
+    StartupStep steps[STARTUP_MAX_STEPS];
+    int count;
+    Uint64 origin, mark;
+} StartupTimeline;
+
+void startupBegin(StartupTimeline* t);
+/* Records the time since the previous mark as the step name. Safe on NULL. */
+void startupMark(StartupTimeline* t, const char* name);
+/* Milliseconds from startupBegin to the last mark. */
+double startupElapsedMs(const StartupTimeline* t);
+void startupPrint(const StartupTimeline* t, FILE* out);
+
+/* Launches exe runs times to its first frame under the dummy video and
+   audio drivers and prints median and p95 wall time. Returns an exit code. */
+int startupBench(const char* exe, int runs);
+
+#endif
@@ -0,0 +1,132 @@
+#include "textcache.h"
+#include <string.h>
+
+void textCacheInit(TextCache* c, SDL_Renderer* renderer) {
+    memset(c, 0, sizeof(*c));
+    c->renderer = renderer;
+}
+
+void textCacheClear(TextCache* c) {
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+        if (c->entries[i].texture) SDL_DestroyTexture(c->entries[i].texture);
+        memset(&c->entries[i], 0, sizeof(c->entries[i]));
+    }
+}
+
+static int sameColor(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+SDL_Texture* textCacheGet(TextCache* c, TTF_Font* font, const char* text, SDL_Color color, int* w, int* h) {
+    if (!font || strlen(text) >= TEXT_CACHE_MAX_LEN) return NULL;
+
+    c->clock++;
+    TextCacheEntry* victim = &c->entries[0];
+    for (int i = 0; i < TEXT_CACHE_SIZE; i++) {
+        TextCacheEntry* e = &c->entries[i];
+        if (e->lastUsed && e->font == font && sameColor(e->color, color) && strcmp(e->text, text) == 0) {
+            e->lastUsed = c->clock;
+            c->hits++;
+            *w = e->w;
+            *h = e->h;
+            return e->texture;
+        }
+        if (e->lastUsed < victim->lastUsed) victim = e;
+    }
+
+    // Miss: rasterize into the least recently used slot
+    c->misses++;
+    SDL_Surface* surf = TTF_RenderText_Solid(font, text, color);
+    if (!surf) return NULL;
+    SDL_Texture* tex = SDL_CreateTextureFromSurface(c->renderer, surf);
+    int sw = surf->w, sh = surf->h;
+    SDL_FreeSurface(surf);
+    if (!tex) return NULL;
+
+    if (victim->texture) SDL_DestroyTexture(victim->texture);
+    strcpy(victim->text, text);
+    victim->color = color;
+    victim->font = font;
+    victim->texture = tex;
+    victim->w = sw;
+    victim->h = sh;
+    victim->lastUsed = c->clock;
+
+    *w = sw;
+    *h = sh;
+    return tex;
+}
+
+int digitStripInit(DigitStrip* d, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color) {
+    memset(d, 0, sizeof(*d));
+    if (!font) return -1;
+
+    SDL_Surface* glyphs[10];
+    int ok = 1;
+    for (int i = 0; i < 10; i++) {
+        char text[2] = {(char)('0' + i), '\0'};
+        glyphs[i] = TTF_RenderText_Solid(font, text, color);
+        if (!glyphs[i]) { ok = 0; continue; }
+        d->x[i] = d->texW;
+        d->w[i] = glyphs[i]->w;
+        d->texW += glyphs[i]->w;
+        if (glyphs[i]->h > d->h) d->h = glyphs[i]->h;
+    }
+
+    SDL_Surface* strip = ok ? SDL_CreateRGBSurfaceWithFormat(0, d->texW, d->h, 32, SDL_PIXELFORMAT_RGBA32) : NULL;
+    if (strip) {
+        SDL_FillRect(strip, NULL, 0); // transparent; the glyphs' colorkey keeps their background out
+        for (int i = 0; i < 10; i++) {
+            SDL_Rect dst = {d->x[i], 0, d->w[i], glyphs[i]->h};
+            SDL_BlitSurface(glyphs[i], NULL, strip, &dst);
+        }
+        d->texture = SDL_CreateTextureFromSurface(renderer, strip);
+        SDL_FreeSurface(strip);
+    }
+    for (int i = 0; i < 10; i++) if (glyphs[i]) SDL_FreeSurface(glyphs[i]);
+    return d->texture ? 0 : -1;
+}
+
+void digitStripFree(DigitStrip* d) {
+    if (d->texture) SDL_DestroyTexture(d->texture);
+    memset(d, 0, sizeof(*d));
+}
+
+/* Digits of value, most significant first; returns the count. */
+static int splitDigits(int value, int digits[10]) {
+    int n = 0;
+    unsigned int v = value > 0 ? (unsigned int)value : 0;
+    do { digits[n++] = v % 10; v /= 10; } while (v && n < 10);
+    for (int i = 0; i < n / 2; i++) { int t = digits[i]; digits[i] = digits[n - 1 - i]; digits[n - 1 - i] = t; }
+    return n;
+}
+
+int digitStripWidth(const DigitStrip* d, int value) {
+    int digits[10], n = splitDigits(value, digits), w = 0;
+    for (int i = 0; i < n; i++) w += d->w[digits[i]];
+    return w;
+}
+
+void digitStripDraw(const DigitStrip* d, SDL_Renderer* renderer, int value, int x, int y) {
+    if (!d->texture) return;
+    int digits[10], n = splitDigits(value, digits);
+    SDL_Vertex vertices[10 * 4];
+    int indices[10 * 6];
+    const SDL_Color white = {255, 255, 255, 255};
+
+    for (int i = 0; i < n; i++) {
+        int g = digits[i];
+        float u0 = (float)d->x[g] / d->texW, u1 = (float)(d->x[g] + d->w[g]) / d->texW;
+        float x0 = (float)x, x1 = (float)(x + d->w[g]), y0 = (float)y, y1 = (float)(y + d->h);
+        SDL_Vertex* v = &vertices[i * 4];
+        v[0] = (SDL_Vertex){{x0, y0}, white, {u0, 0}};
+        v[1] = (SDL_Vertex){{x1, y0}, white, {u1, 0}};
+        v[2] = (SDL_Vertex){{x1, y1}, white, {u1, 1}};
+        v[3] = (SDL_Vertex){{x0, y1}, white, {u0, 1}};
+        int* idx = &indices[i * 6];
+        idx[0] = i * 4; idx[1] = i * 4 + 1; idx[2] = i * 4 + 2;
+        idx[3] = i * 4; idx[4] = i * 4 + 2; idx[5] = i * 4 + 3;
+        x += d->w[g];
+    }
+    SDL_RenderGeometry(renderer, d->texture, vertices, n * 4, indices, n * 6);
+}
@@ -0,0 +1,56 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+/*
+   Keeps rendered text as textures keyed by (string, color, font) so HUD text
+   is only rasterized when it changes. Least recently used entries are
+   evicted once TEXT_CACHE_SIZE textures are held.
+*/
+
+#define TEXT_CACHE_SIZE 16
+#define TEXT_CACHE_MAX_LEN 64
+
+typedef struct {
+    char text[TEXT_CACHE_MAX_LEN];
+    SDL_Color color;
+    TTF_Font* font;
+    SDL_Texture* texture;
+    int w, h;
+    unsigned long lastUsed; // 0 = empty slot
+} TextCacheEntry;
+
+typedef struct {
+    SDL_Renderer* renderer;
+    TextCacheEntry entries[TEXT_CACHE_SIZE];
+    unsigned long clock;
+    unsigned long hits, misses;
+} TextCache;
+
+void textCacheInit(TextCache* c, SDL_Renderer* renderer);
+void textCacheClear(TextCache* c);
+
+/* Returns the texture for text (NULL on failure) and its size in w/h.
+   The texture stays owned by the cache. */
+SDL_Texture* textCacheGet(TextCache* c, TTF_Font* font, const char* text, SDL_Color color, int* w, int* h);
+
+/*
+   The ten digits rasterized once side by side in one texture, so numbers
+   that change mid-game (the score) draw as a single SDL_RenderGeometry call
+   without TTF or the heap. Digits are laid out on their own advance widths,
+   without kerning.
+*/
+typedef struct {
+    SDL_Texture* texture;
+    int x[10], w[10], h, texW;
+} DigitStrip;
+
+int digitStripInit(DigitStrip* d, SDL_Renderer* renderer, TTF_Font* font, SDL_Color color);
+void digitStripFree(DigitStrip* d);
+/* Width value (>= 0) takes when drawn. */
+int digitStripWidth(const DigitStrip* d, int value);
+void digitStripDraw(const DigitStrip* d, SDL_Renderer* renderer, int value, int x, int y);
+
+#endif
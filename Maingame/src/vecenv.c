@@ -0,0 +1,344 @@
+#include "vecenv.h"
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VECENV_X86 1
+#endif
+
+#define NO_PIPE_X (INT32_MAX / 2) // empty near-pipe slot: never overlaps the bird
+
+// Bird x range [BIRD_X, BIRD_X + BIRD_W] against a pipe at screen x, as checkCollision sees it
+#define HIT_MIN_X (BIRD_X - PIPE_WIDTH)
+#define HIT_MAX_X (BIRD_X + BIRD_W)
+#define ZONE_MIN_X (BIRD_X - PIPE_WIDTH / 2 - 1) // score zone is 1 px wide at x + PIPE_WIDTH / 2
+#define ZONE_MAX_X (BIRD_X + BIRD_W - PIPE_WIDTH / 2)
+#define PASSED_X (BIRD_X - PIPE_WIDTH) // pipe fully left of the bird
+
+uint64_t vecEnvCourseSeed(uint64_t seed, int lane, uint32_t episode) {
+    return rngAt(seed, ((uint64_t)(uint32_t)lane << 32) | episode);
+}
+
+static void refreshNear(VecEnv* e, int i) {
+    const int32_t* qx = e->queueX + i * VEC_QUEUE;
+    const int32_t* qh = e->queueH + i * VEC_QUEUE;
+    for (int j = 0; j < VEC_NEAR; j++) {
+        if (j < e->queueCount[i]) {
+            int slot = (e->queueHead[i] + j) & (VEC_QUEUE - 1);
+            e->nearX[j][i] = qx[slot];
+            e->nearH[j][i] = qh[slot];
+        } else {
+            e->nearX[j][i] = NO_PIPE_X;
+            e->nearH[j][i] = 0;
+        }
+    }
+}
+
+static void resetLane(VecEnv* e, int i) {
+    e->birdY[i] = WINDOW_HEIGHT / 2;
+    e->birdVelocity[i] = 0;
+    e->scroll[i] = 0;
+    e->pipeTimer[i] = 0;
+    e->score[i] = 0;
+    for (int j = 0; j < VEC_NEAR; j++) e->nearScored[j][i] = 0;
+    e->courseSeed[i] = vecEnvCourseSeed(e->seed, i, e->episode[i]);
+    e->spawnSlot[i] = 0;
+    e->normalPipeCounter[i] = 0;
+    e->threePipeCooldown[i] = 0;
+    e->queueHead[i] = 0;
+    e->queueCount[i] = 0;
+    refreshNear(e, i);
+}
+
+/* The rare per-bird work a kernel flags: death, a pipe passing the bird, a spawn. */
+static void fixupLane(VecEnv* e, int i, uint8_t action, int died, int passed, int spawn) {
+    if (died) {
+        e->done[i] = 1;
+        e->lastScore[i] = e->score[i];
+        e->episode[i]++;
+        e->episodes++;
+        resetLane(e, i);
+        return;
+    }
+
+    if (passed) {
+        e->queueHead[i] = (e->queueHead[i] + 1) & (VEC_QUEUE - 1);
+        e->queueCount[i]--;
+        for (int j = 0; j + 1 < VEC_NEAR; j++) e->nearScored[j][i] = e->nearScored[j + 1][i];
+        e->nearScored[VEC_NEAR - 1][i] = 0;
+    }
+
+    if (spawn) {
+        // gameStep spawns before moving, so new pipes start at the pre-move scroll
+        int speed = (action & VEC_ACTION_DASH) ? DASH_SPEED : PIPE_SPEED;
+        int height;
+        int n = courseSpawn(e->courseSeed[i], e->spawnSlot[i]++, &e->normalPipeCounter[i], &e->threePipeCooldown[i], &height);
+        e->pipeTimer[i] = 0;
+        for (int j = 0; j < n; j++) {
+            int slot = (e->queueHead[i] + e->queueCount[i]++) & (VEC_QUEUE - 1);
+            e->queueX[i * VEC_QUEUE + slot] = WINDOW_WIDTH + j * PIPE_ROW_SPACING + e->scroll[i] - speed;
+            e->queueH[i * VEC_QUEUE + slot] = height;
+        }
+    }
+
+    refreshNear(e, i);
+}
+
+static void stepScalar(VecEnv* e, const uint8_t* actions, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        uint8_t a = actions[i];
+        float vel = e->birdVelocity[i];
+        if (a & VEC_ACTION_FLAP) vel = FLAP_STRENGTH;
+        vel = (a & VEC_ACTION_DASH) ? 0 : vel + GRAVITY;
+        float y = e->birdY[i] + vel;
+        e->birdVelocity[i] = vel;
+        e->birdY[i] = y;
+
+        int top = (int)y;
+        int died = y <= 0 || y + BIRD_H >= WINDOW_HEIGHT;
+        int scroll = e->scroll[i] += (a & VEC_ACTION_DASH) ? DASH_SPEED : PIPE_SPEED;
+        int inY = top + BIRD_H >= 0 && top <= WINDOW_HEIGHT;
+
+        for (int j = 0; j < VEC_NEAR; j++) {
+            int x = e->nearX[j][i] - scroll, h = e->nearH[j][i];
+            if (x >= HIT_MIN_X && x <= HIT_MAX_X &&
+                ((top <= h && top + BIRD_H >= 0) || (top + BIRD_H >= h + PIPE_GAP && top <= WINDOW_HEIGHT))) died = 1;
+            if (!e->nearScored[j][i] && x >= ZONE_MIN_X && x <= ZONE_MAX_X && inY) {
+                e->score[i]++;
+                e->nearScored[j][i] = 1;
+            }
+        }
+
+        int passed = e->nearX[0][i] - scroll < PASSED_X;
+        int spawn = ++e->pipeTimer[i] > PIPE_SPAWN_TICKS;
+        if (died || passed || spawn) fixupLane(e, i, a, died, passed, spawn);
+    }
+}
+
+#ifdef VECENV_X86
+
+__attribute__((target("avx2")))
+static int stepAVX2(VecEnv* e, const uint8_t* actions, int count) {
+    const __m256i one = _mm256_set1_epi32(1), two = _mm256_set1_epi32(2);
+    const __m256 gravity = _mm256_set1_ps(GRAVITY), flapV = _mm256_set1_ps(FLAP_STRENGTH);
+    const __m256 zeroF = _mm256_setzero_ps(), birdH = _mm256_set1_ps(BIRD_H), winH = _mm256_set1_ps(WINDOW_HEIGHT);
+    const __m256i zero = _mm256_setzero_si256(), birdHi = _mm256_set1_epi32(BIRD_H), winHi = _mm256_set1_epi32(WINDOW_HEIGHT);
+    const __m256i pipeSpeed = _mm256_set1_epi32(PIPE_SPEED), dashSpeed = _mm256_set1_epi32(DASH_SPEED);
+    const __m256i gap = _mm256_set1_epi32(PIPE_GAP), spawnTicks = _mm256_set1_epi32(PIPE_SPAWN_TICKS);
+    const __m256i hitMin = _mm256_set1_epi32(HIT_MIN_X - 1), hitMax = _mm256_set1_epi32(HIT_MAX_X);
+    const __m256i zoneMin = _mm256_set1_epi32(ZONE_MIN_X - 1), zoneMax = _mm256_set1_epi32(ZONE_MAX_X);
+    const __m256i passedX = _mm256_set1_epi32(PASSED_X);
+
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i act = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(actions + i)));
+        __m256i flap = _mm256_cmpeq_epi32(_mm256_and_si256(act, one), one);
+        __m256i dash = _mm256_cmpeq_epi32(_mm256_and_si256(act, two), two);
+
+        __m256 vel = _mm256_loadu_ps(e->birdVelocity + i);
+        vel = _mm256_blendv_ps(vel, flapV, _mm256_castsi256_ps(flap));
+        vel = _mm256_andnot_ps(_mm256_castsi256_ps(dash), _mm256_add_ps(vel, gravity));
+        __m256 y = _mm256_add_ps(_mm256_loadu_ps(e->birdY + i), vel);
+        _mm256_storeu_ps(e->birdVelocity + i, vel);
+        _mm256_storeu_ps(e->birdY + i, y);
+
+        __m256i died = _mm256_castps_si256(_mm256_or_ps(_mm256_cmp_ps(y, zeroF, _CMP_LE_OQ),
+            _mm256_cmp_ps(_mm256_add_ps(y, birdH), winH, _CMP_GE_OQ)));
+        __m256i top = _mm256_cvttps_epi32(y);
+        __m256i bottom = _mm256_add_epi32(top, birdHi);
+        // top + BIRD_H >= 0 && top <= WINDOW_HEIGHT
+        __m256i inY = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpgt_epi32(zero, bottom), _mm256_cmpgt_epi32(top, winHi)),
+            _mm256_set1_epi32(-1));
+
+        __m256i scroll = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(e->scroll + i)),
+            _mm256_blendv_epi8(pipeSpeed, dashSpeed, dash));
+        _mm256_storeu_si256((__m256i*)(e->scroll + i), scroll);
+
+        __m256i score = _mm256_loadu_si256((const __m256i*)(e->score + i));
+        for (int j = 0; j < VEC_NEAR; j++) {
+            __m256i x = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(e->nearX[j] + i)), scroll);
+            __m256i h = _mm256_loadu_si256((const __m256i*)(e->nearH[j] + i));
+            __m256i inX = _mm256_andnot_si256(_mm256_cmpgt_epi32(x, hitMax), _mm256_cmpgt_epi32(x, hitMin));
+            __m256i topHit = _mm256_andnot_si256(_mm256_cmpgt_epi32(top, h), _mm256_andnot_si256(_mm256_cmpgt_epi32(zero, bottom), inX));
+            __m256i bottomHit = _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(h, gap), bottom),
+                _mm256_andnot_si256(_mm256_cmpgt_epi32(top, winHi), inX));
+            died = _mm256_or_si256(died, _mm256_or_si256(topHit, bottomHit));
+
+            __m256i scored = _mm256_loadu_si256((const __m256i*)(e->nearScored[j] + i));
+            __m256i inZone = _mm256_andnot_si256(_mm256_cmpgt_epi32(x, zoneMax), _mm256_cmpgt_epi32(x, zoneMin));
+            __m256i newScore = _mm256_andnot_si256(_mm256_cmpeq_epi32(scored, one), _mm256_and_si256(inZone, inY));
+            score = _mm256_sub_epi32(score, newScore); // mask lanes are -1
+            _mm256_storeu_si256((__m256i*)(e->nearScored[j] + i), _mm256_or_si256(scored, _mm256_and_si256(newScore, one)));
+        }
+        _mm256_storeu_si256((__m256i*)(e->score + i), score);
+
+        __m256i passed = _mm256_cmpgt_epi32(passedX, _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(e->nearX[0] + i)), scroll));
+        __m256i timer = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(e->pipeTimer + i)), one);
+        _mm256_storeu_si256((__m256i*)(e->pipeTimer + i), timer);
+        __m256i spawn = _mm256_cmpgt_epi32(timer, spawnTicks);
+
+        int diedBits = _mm256_movemask_ps(_mm256_castsi256_ps(died));
+        int passedBits = _mm256_movemask_ps(_mm256_castsi256_ps(passed));
+        int spawnBits = _mm256_movemask_ps(_mm256_castsi256_ps(spawn));
+        int any = diedBits | passedBits | spawnBits;
+        while (any) {
+            int k = __builtin_ctz(any);
+            fixupLane(e, i + k, actions[i + k], (diedBits >> k) & 1, (passedBits >> k) & 1, (spawnBits >> k) & 1);
+            any &= any - 1;
+        }
+    }
+    return i;
+}
+
+__attribute__((target("sse2")))
+static int stepSSE2(VecEnv* e, const uint8_t* actions, int count) {
+    const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2), allOnes = _mm_set1_epi32(-1);
+    const __m128 gravity = _mm_set1_ps(GRAVITY), flapV = _mm_set1_ps(FLAP_STRENGTH);
+    const __m128 zeroF = _mm_setzero_ps(), birdH = _mm_set1_ps(BIRD_H), winH = _mm_set1_ps(WINDOW_HEIGHT);
+    const __m128i zero = _mm_setzero_si128(), birdHi = _mm_set1_epi32(BIRD_H), winHi = _mm_set1_epi32(WINDOW_HEIGHT);
+    const __m128i pipeSpeed = _mm_set1_epi32(PIPE_SPEED), dashExtra = _mm_set1_epi32(DASH_SPEED - PIPE_SPEED);
+    const __m128i gap = _mm_set1_epi32(PIPE_GAP), spawnTicks = _mm_set1_epi32(PIPE_SPAWN_TICKS);
+    const __m128i hitMin = _mm_set1_epi32(HIT_MIN_X - 1), hitMax = _mm_set1_epi32(HIT_MAX_X);
+    const __m128i zoneMin = _mm_set1_epi32(ZONE_MIN_X - 1), zoneMax = _mm_set1_epi32(ZONE_MAX_X);
+    const __m128i passedX = _mm_set1_epi32(PASSED_X);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int packed;
+        memcpy(&packed, actions + i, 4);
+        __m128i act = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+        __m128i flap = _mm_cmpeq_epi32(_mm_and_si128(act, one), one);
+        __m128i dash = _mm_cmpeq_epi32(_mm_and_si128(act, two), two);
+
+        __m128 vel = _mm_loadu_ps(e->birdVelocity + i);
+        __m128 flapMask = _mm_castsi128_ps(flap);
+        vel = _mm_or_ps(_mm_and_ps(flapMask, flapV), _mm_andnot_ps(flapMask, vel));
+        vel = _mm_andnot_ps(_mm_castsi128_ps(dash), _mm_add_ps(vel, gravity));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(e->birdY + i), vel);
+        _mm_storeu_ps(e->birdVelocity + i, vel);
+        _mm_storeu_ps(e->birdY + i, y);
+
+        __m128i died = _mm_castps_si128(_mm_or_ps(_mm_cmple_ps(y, zeroF), _mm_cmpge_ps(_mm_add_ps(y, birdH), winH)));
+        __m128i top = _mm_cvttps_epi32(y);
+        __m128i bottom = _mm_add_epi32(top, birdHi);
+        __m128i inY = _mm_andnot_si128(_mm_or_si128(_mm_cmpgt_epi32(zero, bottom), _mm_cmpgt_epi32(top, winHi)), allOnes);
+
+        __m128i scroll = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(e->scroll + i)),
+            _mm_add_epi32(pipeSpeed, _mm_and_si128(dash, dashExtra)));
+        _mm_storeu_si128((__m128i*)(e->scroll + i), scroll);
+
+        __m128i score = _mm_loadu_si128((const __m128i*)(e->score + i));
+        for (int j = 0; j < VEC_NEAR; j++) {
+            __m128i x = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(e->nearX[j] + i)), scroll);
+            __m128i h = _mm_loadu_si128((const __m128i*)(e->nearH[j] + i));
+            __m128i inX = _mm_andnot_si128(_mm_cmpgt_epi32(x, hitMax), _mm_cmpgt_epi32(x, hitMin));
+            __m128i topHit = _mm_andnot_si128(_mm_cmpgt_epi32(top, h), _mm_andnot_si128(_mm_cmpgt_epi32(zero, bottom), inX));
+            __m128i bottomHit = _mm_andnot_si128(_mm_cmpgt_epi32(_mm_add_epi32(h, gap), bottom),
+                _mm_andnot_si128(_mm_cmpgt_epi32(top, winHi), inX));
+            died = _mm_or_si128(died, _mm_or_si128(topHit, bottomHit));
+
+            __m128i scored = _mm_loadu_si128((const __m128i*)(e->nearScored[j] + i));
+            __m128i inZone = _mm_andnot_si128(_mm_cmpgt_epi32(x, zoneMax), _mm_cmpgt_epi32(x, zoneMin));
+            __m128i newScore = _mm_andnot_si128(_mm_cmpeq_epi32(scored, one), _mm_and_si128(inZone, inY));
+            score = _mm_sub_epi32(score, newScore);
+            _mm_storeu_si128((__m128i*)(e->nearScored[j] + i), _mm_or_si128(scored, _mm_and_si128(newScore, one)));
+        }
+        _mm_storeu_si128((__m128i*)(e->score + i), score);
+
+        __m128i passed = _mm_cmpgt_epi32(passedX, _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(e->nearX[0] + i)), scroll));
+        __m128i timer = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(e->pipeTimer + i)), one);
+        _mm_storeu_si128((__m128i*)(e->pipeTimer + i), timer);
+        __m128i spawn = _mm_cmpgt_epi32(timer, spawnTicks);
+
+        int diedBits = _mm_movemask_ps(_mm_castsi128_ps(died));
+        int passedBits = _mm_movemask_ps(_mm_castsi128_ps(passed));
+        int spawnBits = _mm_movemask_ps(_mm_castsi128_ps(spawn));
+        int any = diedBits | passedBits | spawnBits;
+        while (any) {
+            int k = __builtin_ctz(any);
+            fixupLane(e, i + k, actions[i + k], (diedBits >> k) & 1, (passedBits >> k) & 1, (spawnBits >> k) & 1);
+            any &= any - 1;
+        }
+    }
+    return i;
+}
+
+#endif
+
+static int pickKernel(void) {
+#ifdef VECENV_X86
+    if (__builtin_cpu_supports("avx2")) return 2;
+    if (__builtin_cpu_supports("sse2")) return 1;
+#endif
+    return 0;
+}
+
+const char* vecEnvKernel(void) {
+    static const char* names[] = {"scalar", "sse2", "avx2"};
+    return names[pickKernel()];
+}
+
+void vecEnvStep(VecEnv* e, const uint8_t* actions) {
+    memset(e->done, 0, e->count);
+    int done = 0;
+#ifdef VECENV_X86
+    if (e->kernel == 2) done = stepAVX2(e, actions, e->count);
+    else if (e->kernel == 1) done = stepSSE2(e, actions, e->count);
+#endif
+    stepScalar(e, actions, done, e->count); // remainder lanes, or everything without SIMD
+    e->steps += e->count;
+}
+
+void vecEnvObserve(const VecEnv* e, float* obs) {
+    for (int i = 0; i < e->count; i++) {
+        float* o = obs + i * VEC_OBS_DIM;
+        o[0] = e->birdY[i] / WINDOW_HEIGHT;
+        o[1] = e->birdVelocity[i] / 10.0f;
+        for (int j = 0; j < 2; j++) {
+            int present = e->nearX[j][i] != NO_PIPE_X;
+            o[2 + 2 * j] = present ? (float)(e->nearX[j][i] - e->scroll[i] - BIRD_X) / WINDOW_WIDTH : 1.0f;
+            o[3 + 2 * j] = present ? (float)e->nearH[j][i] / WINDOW_HEIGHT : 0.5f;
+        }
+    }
+}
+
+int vecEnvInit(VecEnv* e, int count, uint64_t seed) {
+    memset(e, 0, sizeof(*e));
+    e->count = count;
+    e->kernel = pickKernel();
+    e->seed = seed;
+
+    // One allocation, carved into arrays; 4-byte fields first keep everything aligned
+    size_t n = (size_t)count;
+    size_t bytes = n * (sizeof(float) * 2 + sizeof(int32_t) * (6 + 3 * VEC_NEAR) + sizeof(uint32_t) * 2 + sizeof(uint64_t) + 3) +
+                   n * VEC_QUEUE * sizeof(int32_t) * 2 + 64;
+    char* p = calloc(1, bytes);
+    if (!p) return -1;
+    e->block = p;
+
+    e->courseSeed = (uint64_t*)p; p += n * sizeof(uint64_t);
+    e->birdY = (float*)p; p += n * sizeof(float);
+    e->birdVelocity = (float*)p; p += n * sizeof(float);
+    int32_t** ints[] = {&e->scroll, &e->pipeTimer, &e->score, &e->lastScore, &e->normalPipeCounter, &e->threePipeCooldown};
+    for (size_t k = 0; k < sizeof(ints) / sizeof(ints[0]); k++) { *ints[k] = (int32_t*)p; p += n * sizeof(int32_t); }
+    for (int j = 0; j < VEC_NEAR; j++) {
+        e->nearX[j] = (int32_t*)p; p += n * sizeof(int32_t);
+        e->nearH[j] = (int32_t*)p; p += n * sizeof(int32_t);
+        e->nearScored[j] = (int32_t*)p; p += n * sizeof(int32_t);
+    }
+    e->episode = (uint32_t*)p; p += n * sizeof(uint32_t);
+    e->spawnSlot = (uint32_t*)p; p += n * sizeof(uint32_t);
+    e->queueX = (int32_t*)p; p += n * VEC_QUEUE * sizeof(int32_t);
+    e->queueH = (int32_t*)p; p += n * VEC_QUEUE * sizeof(int32_t);
+    e->done = (uint8_t*)p; p += n;
+    e->queueHead = (uint8_t*)p; p += n;
+    e->queueCount = (uint8_t*)p;
+
+    for (int i = 0; i < count; i++) resetLane(e, i);
+    return 0;
+}
+
+void vecEnvFree(VecEnv* e) {
+    free(e->block);
+    memset(e, 0, sizeof(*e));
+}
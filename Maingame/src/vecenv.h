@@ -0,0 +1,73 @@
+#ifndef VECENV_H
+#define VECENV_H
+
+#include "game.h"
+
+/*
+   K birds stepped together for training. Per-bird state is kept as
+   structure-of-arrays so gravity, bounds, pipe collision and scoring run 8
+   lanes at a time with AVX2, 4 with SSE2, or one at a time elsewhere. At
+   most three pipes overlap the bird's x range at once (a triple's last pipe
+   and the next spawn can be 23 px apart), so only the three oldest pipes a
+   bird hasn't passed are mirrored into SoA lanes, in world x against a
+   per-bird scroll offset.
+   Spawning, retiring passed pipes and resets happen every ~80 ticks per
+   bird and stay scalar. A bird that dies is reset on the spot, like
+   gameReset, with the next course for its lane.
+
+   Lane i, episode n plays exactly the course (and physics) gameStep would
+   for seed vecEnvCourseSeed(seed, i, n).
+*/
+
+#define VEC_ACTION_FLAP 1
+#define VEC_ACTION_DASH 2
+#define VEC_OBS_DIM 6 // birdY, birdVelocity, then (dx, height) of the next two pipes
+#define VEC_NEAR 3
+#define VEC_QUEUE 16 // pipes a bird hasn't passed yet; the spawn rate allows at most 10
+
+typedef struct {
+    int count;
+    int kernel; // 2 = AVX2, 1 = SSE2, 0 = scalar only
+    uint64_t seed;
+
+    // Hot SoA lanes, touched every step
+    float* birdY;
+    float* birdVelocity;
+    int32_t* scroll; // how far this bird's pipes have moved left since reset
+    int32_t* pipeTimer;
+    int32_t* score;
+    int32_t* nearX[VEC_NEAR]; // world x of the oldest pipes not yet passed
+    int32_t* nearH[VEC_NEAR];
+    int32_t* nearScored[VEC_NEAR];
+
+    // Step outputs: envs that died during the last step (and were reset)
+    uint8_t* done;
+    int32_t* lastScore;
+
+    // Cold per-bird state for the scalar spawner
+    uint64_t* courseSeed;
+    uint32_t* episode;
+    uint32_t* spawnSlot;
+    int32_t* normalPipeCounter;
+    int32_t* threePipeCooldown;
+    int32_t* queueX; // [count][VEC_QUEUE] ring, world x
+    int32_t* queueH;
+    uint8_t* queueHead;
+    uint8_t* queueCount;
+
+    unsigned long long steps, episodes;
+    void* block;
+} VecEnv;
+
+int vecEnvInit(VecEnv* e, int count, uint64_t seed);
+void vecEnvFree(VecEnv* e);
+uint64_t vecEnvCourseSeed(uint64_t seed, int lane, uint32_t episode);
+
+/* Steps every bird once; actions[i] holds VEC_ACTION_* bits for bird i. */
+void vecEnvStep(VecEnv* e, const uint8_t* actions);
+/* Writes a dense [count][VEC_OBS_DIM] observation tensor, roughly in [-1, 1]. */
+void vecEnvObserve(const VecEnv* e, float* obs);
+/* Which step kernel this CPU uses: "avx2", "sse2" or "scalar". */
+const char* vecEnvKernel(void);
+
+#endif
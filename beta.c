@@ -8,44 +8,22 @@
 #include <stdlib.h>
 #include <time.h>
 #include <emscripten.h>
-
-#define WINDOW_WIDTH 1280
-#define WINDOW_HEIGHT 720
-#define PIPE_WIDTH 100
-#define PIPE_GAP 250
-#define MAX_PIPES 20
-
-typedef struct {
-    int x, height;
-    int active;
-    int scored;
-} Pipe;
+#include "Maingame/src/game.h"
+#include "Maingame/src/textcache.h"
 
 /* 
    Global game state
     */
 static int running = 1;
-static int gameOver = 0;
 static int inMenu = 1;
 static SDL_Event event;
 
-static float birdY;
-static float birdVelocity;
-static const float gravity = 0.25f;
-static const float flapStrength = -8.0f;
-static const int pipeSpeed = 3;
-static const int dashSpeed = 12;
-
-static Pipe pipes[MAX_PIPES];
-static int pipeTimer;
-static int score;
-static int normalPipeCounter;
-static int threePipeCooldown;
+static GameState game;
+static uint64_t sessionSeed;
+static unsigned int gamesStarted = 0;
 
-static SDL_Rect birdRect;
 static SDL_Rect restartButton;
 static SDL_Rect startButton;
-static SDL_Texture* currentBirdTexture = NULL;
 static int dashChannel = -1;
 
 /* SDL objects */
@@ -66,34 +44,8 @@ static Mix_Chunk* dedSfx = NULL;
 static Mix_Chunk* crossSfx = NULL;
 
 static TTF_Font* font = NULL;
-
-/* -----------------------
-   Utility functions
-   ----------------------- */
-int checkCollision(SDL_Rect a, SDL_Rect b) {
-    return !(a.x + a.w < b.x ||
-             a.x > b.x + b.w ||
-             a.y + a.h < b.y ||
-             a.y > b.y + b.h);
-}
-
-void resetGame() {
-    birdY = WINDOW_HEIGHT / 2.0f;
-    birdVelocity = 0.0f;
-    for (int i = 0; i < MAX_PIPES; ++i) {
-        pipes[i].active = 0;
-        pipes[i].scored = 0;
-    }
-    pipeTimer = 0;
-    score = 0;
-    normalPipeCounter = 0;
-    threePipeCooldown = 0;
-
-    birdRect.x = 250;
-    birdRect.y = (int)birdY;
-    birdRect.w = 106;
-    birdRect.h = 60;
-}
+static TextCache textCache;
+static const SDL_Color white = {255, 255, 255, 255};
 
 /* Cleanup resources and stop the main loop */
 void cleanup() {
@@ -104,6 +56,7 @@ void cleanup() {
     if (crossSfx) { Mix_FreeChunk(crossSfx); crossSfx = NULL; }
     Mix_CloseAudio();
 
+    textCacheClear(&textCache);
     if (font) { TTF_CloseFont(font); font = NULL; }
     TTF_Quit();
     IMG_Quit();
@@ -133,7 +86,7 @@ void gameLoop() {
         return;
     }
 
-    int dash = 0;
+    GameInput input = {0, 0};
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
             running = 0;
@@ -147,23 +100,18 @@ void gameLoop() {
                 if (mx >= startButton.x && mx <= startButton.x + startButton.w &&
                     my >= startButton.y && my <= startButton.y + startButton.h) {
                     inMenu = 0;
-                    resetGame();
+                    gameReset(&game, sessionSeed + gamesStarted++);
                 }
             }
         } else {
             if (event.type == SDL_KEYDOWN) {
-                if (!gameOver) {
-                    if (event.key.keysym.sym == SDLK_SPACE) {
-                        birdVelocity = flapStrength;
-                        if (jumpSfx) Mix_PlayChannel(-1, jumpSfx, 0);
-                    }
+                if (!game.gameOver) {
+                    if (event.key.keysym.sym == SDLK_SPACE) input.flap = 1;
                     if ((event.key.keysym.sym == SDLK_LSHIFT || event.key.keysym.sym == SDLK_RSHIFT) && dashChannel == -1) {
-                        dash = 1;
                         if (dashSfx) dashChannel = Mix_PlayChannel(-1, dashSfx, -1);
                     }
                 } else if (event.key.keysym.sym == SDLK_r) {
-                    resetGame();
-                    gameOver = 0;
+                    gameReset(&game, sessionSeed + gamesStarted++);
                 }
             }
 
@@ -173,110 +121,25 @@ void gameLoop() {
                 }
             }
 
-            if (event.type == SDL_MOUSEBUTTONDOWN && gameOver) {
+            if (event.type == SDL_MOUSEBUTTONDOWN && game.gameOver) {
                 int mx = event.button.x;
                 int my = event.button.y;
                 if (mx >= restartButton.x && mx <= restartButton.x + restartButton.w &&
                     my >= restartButton.y && my <= restartButton.y + restartButton.h) {
-                    resetGame();
-                    gameOver = 0;
+                    gameReset(&game, sessionSeed + gamesStarted++);
                 }
             }
         }
     }
 
     const Uint8* state = SDL_GetKeyboardState(NULL);
-    int shiftHeld = state[SDL_SCANCODE_LSHIFT] || state[SDL_SCANCODE_RSHIFT];
-
-    if (!inMenu && !gameOver) {
-        int currentPipeSpeed = pipeSpeed;
-        if (shiftHeld) {
-            birdVelocity = 0;
-            currentPipeSpeed = dashSpeed;
-            currentBirdTexture = birdDashTexture ? birdDashTexture : birdTexture;
-        } else {
-            currentBirdTexture = birdTexture;
-        }
-
-        if (!shiftHeld) birdVelocity += gravity;
-        birdY += birdVelocity;
-        birdRect.y = (int)birdY;
-
-        if (birdY <= 0 || birdY + birdRect.h >= WINDOW_HEIGHT) {
-            gameOver = 1;
-            if (dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
-        }
+    input.dash = state[SDL_SCANCODE_LSHIFT] || state[SDL_SCANCODE_RSHIFT];
 
-        /* Pipe spawning */
-        pipeTimer++;
-        if (pipeTimer > 80) {
-            pipeTimer = 0;
-            if (threePipeCooldown > 0) {
-                for (int i = 0; i < MAX_PIPES; i++) {
-                    if (!pipes[i].active) {
-                        pipes[i].active = 1;
-                        pipes[i].x = WINDOW_WIDTH;
-                        pipes[i].height = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                        pipes[i].scored = 0;
-                        break;
-                    }
-                }
-                threePipeCooldown--;
-                normalPipeCounter++;
-            } else {
-                if (normalPipeCounter >= 3 && rand() % 5 == 0) {
-                    int baseHeight = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                    for (int j = 0; j < 3; j++) {
-                        for (int i = 0; i < MAX_PIPES; i++) {
-                            if (!pipes[i].active) {
-                                pipes[i].active = 1;
-                                pipes[i].x = WINDOW_WIDTH + j * (PIPE_WIDTH + 10);
-                                pipes[i].height = baseHeight;
-                                pipes[i].scored = 0;
-                                break;
-                            }
-                        }
-                    }
-                    normalPipeCounter = 0;
-                    threePipeCooldown = 3;
-                } else {
-                    for (int i = 0; i < MAX_PIPES; i++) {
-                        if (!pipes[i].active) {
-                            pipes[i].active = 1;
-                            pipes[i].x = WINDOW_WIDTH;
-                            pipes[i].height = 50 + rand() % (WINDOW_HEIGHT - PIPE_GAP - 100);
-                            pipes[i].scored = 0;
-                            break;
-                        }
-                    }
-                    normalPipeCounter++;
-                }
-            }
-        }
-
-        /* Move pipes & collisions */
-        for (int i = 0; i < MAX_PIPES; i++) {
-            if (pipes[i].active) {
-                pipes[i].x -= currentPipeSpeed;
-
-                SDL_Rect topPipe = {pipes[i].x, 0, PIPE_WIDTH, pipes[i].height};
-                SDL_Rect bottomPipe = {pipes[i].x, pipes[i].height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - pipes[i].height - PIPE_GAP};
-                SDL_Rect scoreZone = {pipes[i].x + PIPE_WIDTH / 2, 0, 1, WINDOW_HEIGHT};
-
-                if (checkCollision(birdRect, topPipe) || checkCollision(birdRect, bottomPipe)) {
-                    gameOver = 1;
-                    if (dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
-                }
-
-                if (!pipes[i].scored && checkCollision(birdRect, scoreZone)) {
-                    score++;
-                    pipes[i].scored = 1;
-                    if (crossSfx) Mix_PlayChannel(-1, crossSfx, 0);
-                }
-
-                if (pipes[i].x + PIPE_WIDTH < 0) pipes[i].active = 0;
-            }
-        }
+    if (!inMenu && !game.gameOver) {
+        int events = gameStep(&game, input);
+        if ((events & GAME_EVENT_FLAP) && jumpSfx) Mix_PlayChannel(-1, jumpSfx, 0);
+        if ((events & GAME_EVENT_SCORE) && crossSfx) Mix_PlayChannel(-1, crossSfx, 0);
+        if ((events & GAME_EVENT_DIED) && dedSfx) Mix_PlayChannel(-1, dedSfx, 0);
     }
 
     /* Rendering */
@@ -285,47 +148,38 @@ void gameLoop() {
 
     if (inMenu) {
         if (startTexture) SDL_RenderCopy(renderer, startTexture, NULL, &startButton);
-        if (font) {
-            SDL_Color white = {255, 255, 255, 255};
-            SDL_Surface* creditSurf = TTF_RenderText_Solid(font, "Assets made by Wish Techawashira", white);
-            if (creditSurf) {
-                SDL_Texture* creditTex = SDL_CreateTextureFromSurface(renderer, creditSurf);
-                SDL_Rect creditRect = {20, WINDOW_HEIGHT - creditSurf->h - 20, creditSurf->w, creditSurf->h};
-                if (creditTex) SDL_RenderCopy(renderer, creditTex, NULL, &creditRect);
-                SDL_FreeSurface(creditSurf);
-                SDL_DestroyTexture(creditTex);
-            }
+        int w, h;
+        SDL_Texture* creditTex = textCacheGet(&textCache, font, "Assets made by Wish Techawashira", white, &w, &h);
+        if (creditTex) {
+            SDL_Rect creditRect = {20, WINDOW_HEIGHT - h - 20, w, h};
+            SDL_RenderCopy(renderer, creditTex, NULL, &creditRect);
         }
     } else {
-        for (int i = 0; i < MAX_PIPES; i++) {
-            if (pipes[i].active) {
-                SDL_Rect top = {pipes[i].x, 0, PIPE_WIDTH, pipes[i].height};
-                SDL_Rect bottom = {pipes[i].x, pipes[i].height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - pipes[i].height - PIPE_GAP};
-                if (pipeTopTexture) SDL_RenderCopy(renderer, pipeTopTexture, NULL, &top);
-                if (pipeBottomTexture) SDL_RenderCopy(renderer, pipeBottomTexture, NULL, &bottom);
-            }
+        for (int k = 0; k < game.pipeCount; k++) {
+            const Pipe* p = gamePipeConst(&game, game.pipeHead + k);
+            SDL_Rect top = {p->x, 0, PIPE_WIDTH, p->height};
+            SDL_Rect bottom = {p->x, p->height + PIPE_GAP, PIPE_WIDTH, WINDOW_HEIGHT - p->height - PIPE_GAP};
+            if (pipeTopTexture) SDL_RenderCopy(renderer, pipeTopTexture, NULL, &top);
+            if (pipeBottomTexture) SDL_RenderCopy(renderer, pipeBottomTexture, NULL, &bottom);
         }
 
-        float angle = -birdVelocity * 3.0f;
+        float angle = -game.birdVelocity * 3.0f;
         if (angle > 45.0f) angle = 45.0f;
         if (angle < -45.0f) angle = -45.0f;
+        SDL_Texture* currentBirdTexture = (game.dashing && birdDashTexture) ? birdDashTexture : birdTexture;
+        SDL_Rect birdRect = {game.birdRect.x, game.birdRect.y, game.birdRect.w, game.birdRect.h};
         if (currentBirdTexture) SDL_RenderCopyEx(renderer, currentBirdTexture, NULL, &birdRect, angle, NULL, SDL_FLIP_NONE);
 
-        if (font) {
-            char scoreStr[16];
-            sprintf(scoreStr, "Score: %d", score);
-            SDL_Color white = {255, 255, 255, 255};
-            SDL_Surface* scoreSurf = TTF_RenderText_Solid(font, scoreStr, white);
-            if (scoreSurf) {
-                SDL_Texture* scoreTex = SDL_CreateTextureFromSurface(renderer, scoreSurf);
-                SDL_Rect scoreRect = {WINDOW_WIDTH/2 - scoreSurf->w/2, 20, scoreSurf->w, scoreSurf->h};
-                if (scoreTex) SDL_RenderCopy(renderer, scoreTex, NULL, &scoreRect);
-                SDL_FreeSurface(scoreSurf);
-                SDL_DestroyTexture(scoreTex);
-            }
+        char scoreStr[16];
+        sprintf(scoreStr, "Score: %d", game.score);
+        int w, h;
+        SDL_Texture* scoreTex = textCacheGet(&textCache, font, scoreStr, white, &w, &h);
+        if (scoreTex) {
+            SDL_Rect scoreRect = {WINDOW_WIDTH/2 - w/2, 20, w, h};
+            SDL_RenderCopy(renderer, scoreTex, NULL, &scoreRect);
         }
 
-        if (gameOver && restartTexture) SDL_RenderCopy(renderer, restartTexture, NULL, &restartButton);
+        if (game.gameOver && restartTexture) SDL_RenderCopy(renderer, restartTexture, NULL, &restartButton);
     }
 
     SDL_RenderPresent(renderer);
@@ -336,7 +190,7 @@ void gameLoop() {
    Main initialization
     */
 int main(int argc, char* argv[]) {
-    srand((unsigned int)time(NULL));
+    sessionSeed = (uint64_t)time(NULL);
 
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
         printf("SDL_Init failed: %s\n", SDL_GetError());
@@ -408,23 +262,10 @@ int main(int argc, char* argv[]) {
 
     font = TTF_OpenFont("assets/fonts/Fraktur.ttf", 48);
     if (!font) printf("Failed to load font: %s\n", TTF_GetError());
+    textCacheInit(&textCache, renderer);
 
     /*variables */
-    birdY = WINDOW_HEIGHT / 2.0f;
-    birdVelocity = 0.0f;
-    for (int i = 0; i < MAX_PIPES; i++) {
-        pipes[i].active = 0;
-        pipes[i].scored = 0;
-    }
-    pipeTimer = 0;
-    score = 0;
-    normalPipeCounter = 0;
-    threePipeCooldown = 0;
-
-    birdRect.x = 250;
-    birdRect.y = (int)birdY;
-    birdRect.w = 106;
-    birdRect.h = 60;
+    gameReset(&game, sessionSeed);
 
     restartButton.x = WINDOW_WIDTH/2 - 150;
     restartButton.y = WINDOW_HEIGHT/2 - 50;
@@ -436,7 +277,6 @@ int main(int argc, char* argv[]) {
     startButton.w = 800;
     startButton.h = 200;
 
-    currentBirdTexture = birdTexture;
     dashChannel = -1;
 
     /* mainloop on browser*/